@@ -0,0 +1,306 @@
+#include "ansiparser.h"
+#include <utility>
+
+AnsiParser::AnsiParser(TerminalScreen* screen) :
+    screen(screen)
+{
+}
+
+void AnsiParser::reset()
+{
+    decoder.resetState();
+    highSurrogate = 0;
+    state = State::Ground;
+    params.clear();
+    paramStarted = false;
+    privateMarker = 0;
+    cursorKeysMode = false;
+    bracketedPasteMode = false;
+    screen->reset();
+}
+
+QByteArray AnsiParser::takeReplies()
+{
+    return std::exchange(replies, QByteArray());
+}
+
+void AnsiParser::feed(const QByteArray& output)
+{
+    // the decoder holds on to a utf-8 sequence cut off at the end of the chunk until the rest arrives
+    const QString text = decoder.decode(output);
+    for(const QChar c : text){
+        const char16_t unit = c.unicode();
+        if(QChar::isHighSurrogate(unit)){
+            highSurrogate = unit;
+            continue;
+        }
+        if(QChar::isLowSurrogate(unit)){
+            if(highSurrogate != 0) process(QChar::surrogateToUcs4(highSurrogate, unit));
+            highSurrogate = 0;
+            continue;
+        }
+        highSurrogate = 0;
+        process(unit);
+    }
+}
+
+void AnsiParser::process(char32_t character)
+{
+    // these interrupt whatever sequence is in progress, no matter the state
+    if(character == 0x18 || character == 0x1A){ // CAN, SUB
+        state = State::Ground;
+        return;
+    }
+    if(character == 0x1B){
+        state = State::Escape;
+        return;
+    }
+
+    switch(state){
+    case State::Ground:
+        if(character < 0x20 || character == 0x7F) executeControl(character);
+        else screen->print(character);
+        return;
+
+    case State::Escape:
+        if(character < 0x20){
+            executeControl(character);
+            return;
+        }
+        escapeDispatch(character);
+        return;
+
+    case State::EscapeIntermediate:
+        if(character < 0x20) executeControl(character);
+        else state = State::Ground; // the character set designations, everything is treated as utf-8
+        return;
+
+    case State::Csi:
+        if(character < 0x20){
+            executeControl(character); // controls inside a sequence still happen, like in a real vt
+            return;
+        }
+        if(character >= u'0' && character <= u'9'){
+            if(params.isEmpty()) params.append(0);
+            int& value = params.last();
+            value = qMin(value * 10 + int(character - u'0'), maxParamValue);
+            paramStarted = true;
+            return;
+        }
+        if(character == u';' || character == u':'){ // ':' separates sub parameters (38:2:r:g:b), close enough to ';'
+            if(params.isEmpty()) params.append(0);
+            if(params.size() < maxParams) params.append(0);
+            paramStarted = true;
+            return;
+        }
+        if(character >= 0x3C && character <= 0x3F){ // < = > ?
+            if(paramStarted || privateMarker != 0) state = State::CsiIgnore;
+            else privateMarker = character;
+            return;
+        }
+        if(character >= 0x20 && character <= 0x2F) return; // intermediates, nothing implemented uses them
+        if(character >= 0x40 && character <= 0x7E){
+            state = State::Ground;
+            csiDispatch(character);
+            return;
+        }
+        state = State::CsiIgnore;
+        return;
+
+    case State::CsiIgnore:
+        if(character < 0x20) executeControl(character);
+        else if(character >= 0x40 && character <= 0x7E) state = State::Ground;
+        return;
+
+    case State::OscString:
+        // window titles and such, theres nowhere to show them
+        if(character == 0x07) state = State::Ground;
+        return;
+
+    case State::IgnoreString:
+        return; // ends with ESC '\', which the check above takes care of
+    }
+}
+
+void AnsiParser::executeControl(char32_t control)
+{
+    switch(control){
+    case 0x08: screen->backspace(); break;
+    case 0x09: screen->tab(); break;
+    case 0x0A: // LF, VT and FF all just move down
+    case 0x0B:
+    case 0x0C: screen->lineFeed(); break;
+    case 0x0D: screen->carriageReturn(); break;
+    default: break; // BEL and the rest do nothing here
+    }
+}
+
+void AnsiParser::escapeDispatch(char32_t final)
+{
+    state = State::Ground;
+    switch(final){
+    case u'[':
+        state = State::Csi;
+        params.clear();
+        paramStarted = false;
+        privateMarker = 0;
+        break;
+    case u']': state = State::OscString; break;
+    case u'P': // DCS
+    case u'X': // SOS
+    case u'^': // PM
+    case u'_': state = State::IgnoreString; break; // APC
+    case u'(':
+    case u')':
+    case u'*':
+    case u'+':
+    case u'#':
+    case u'%': state = State::EscapeIntermediate; break;
+    case u'7': screen->saveCursor(); break;
+    case u'8': screen->restoreCursor(); break;
+    case u'D': screen->lineFeed(); break;
+    case u'E':
+        screen->carriageReturn();
+        screen->lineFeed();
+        break;
+    case u'M': screen->reverseIndex(); break;
+    case u'c': reset(); break;
+    default: break; // ESC '\' (the end of a string) and keypad modes
+    }
+}
+
+int AnsiParser::param(int index, int fallback) const
+{
+    const int value = params.value(index, 0);
+    return value == 0 ? fallback : value;
+}
+
+void AnsiParser::csiDispatch(char32_t final)
+{
+    if(privateMarker == u'?'){
+        if(final == u'h' || final == u'l'){
+            for(const int mode : params) setPrivateMode(mode, final == u'h');
+        }
+        return;
+    }
+    if(privateMarker != 0) return; // secondary device attributes and other things nobody needs an answer to
+
+    switch(final){
+    case u'@': screen->insertCharacters(param(0, 1)); break;
+    case u'A': screen->moveCursorBy(-param(0, 1), 0); break;
+    case u'B': screen->moveCursorBy(param(0, 1), 0); break;
+    case u'C': screen->moveCursorBy(0, param(0, 1)); break;
+    case u'D': screen->moveCursorBy(0, -param(0, 1)); break;
+    case u'E':
+        screen->moveCursorBy(param(0, 1), 0);
+        screen->carriageReturn();
+        break;
+    case u'F':
+        screen->moveCursorBy(-param(0, 1), 0);
+        screen->carriageReturn();
+        break;
+    case u'G':
+    case u'`': screen->moveCursor(screen->cursorRow(), param(0, 1) - 1); break;
+    case u'd': screen->moveCursor(param(0, 1) - 1, screen->cursorColumn()); break;
+    case u'H':
+    case u'f': screen->moveCursor(param(0, 1) - 1, param(1, 1) - 1); break;
+    case u'J': screen->eraseInDisplay(params.value(0, 0)); break;
+    case u'K': screen->eraseInLine(params.value(0, 0)); break;
+    case u'L': screen->insertLines(param(0, 1)); break;
+    case u'M': screen->deleteLines(param(0, 1)); break;
+    case u'P': screen->deleteCharacters(param(0, 1)); break;
+    case u'S': screen->scrollUp(param(0, 1)); break;
+    case u'T': screen->scrollDown(param(0, 1)); break;
+    case u'X': screen->eraseCharacters(param(0, 1)); break;
+    case u'm': selectGraphicRendition(); break;
+    case u'r': screen->setScrollRegion(param(0, 1) - 1, param(1, screen->rows()) - 1); break;
+    case u's': screen->saveCursor(); break;
+    case u'u': screen->restoreCursor(); break;
+    case u'c': // primary device attributes, a vt100 with advanced video
+        if(params.value(0, 0) == 0) replies.append("\x1b[?1;2c");
+        break;
+    case u'n': // device status report
+        if(params.value(0, 0) == 5){
+            replies.append("\x1b[0n");
+        }
+        else if(params.value(0, 0) == 6){
+            replies.append("\x1b[" + QByteArray::number(screen->cursorRow() + 1) + ';'
+                           + QByteArray::number(screen->cursorColumn() + 1) + 'R');
+        }
+        break;
+    default: break;
+    }
+}
+
+void AnsiParser::setPrivateMode(int mode, bool on)
+{
+    switch(mode){
+    case 1: cursorKeysMode = on; break;
+    case 7: screen->setAutoWrap(on); break;
+    case 25: screen->setCursorVisible(on); break;
+    case 47:
+    case 1047: screen->setAlternateScreen(on); break;
+    case 1049: // the alternate screen, saving the cursor on the way in and putting it back on the way out
+        if(on){
+            screen->saveCursor();
+            screen->setAlternateScreen(true);
+            screen->eraseInDisplay(2);
+        }
+        else{
+            screen->setAlternateScreen(false);
+            screen->restoreCursor();
+        }
+        break;
+    case 2004: bracketedPasteMode = on; break;
+    default: break;
+    }
+}
+
+void AnsiParser::selectGraphicRendition()
+{
+    TerminalStyle& style = screen->style();
+    if(params.isEmpty()){
+        style = TerminalStyle();
+        return;
+    }
+
+    // 38 and 48 take the color as the next few parameters, 5;n for the palette or 2;r;g;b
+    auto extendedColor = [this](int& i) -> quint32 {
+        const int kind = params.value(i + 1, -1);
+        if(kind == 5 && i + 2 < params.size()){
+            i += 2;
+            return quint32(qBound(0, params.at(i), 255));
+        }
+        if(kind == 2 && i + 4 < params.size()){
+            const quint32 red = quint32(qBound(0, params.at(i + 2), 255));
+            const quint32 green = quint32(qBound(0, params.at(i + 3), 255));
+            const quint32 blue = quint32(qBound(0, params.at(i + 4), 255));
+            i += 4;
+            return TerminalStyle::TrueColorFlag | (red << 16) | (green << 8) | blue;
+        }
+        i = params.size(); // dont know how many parameters it was meant to take, so nothing after it can be trusted
+        return TerminalStyle::DefaultColor;
+    };
+
+    for(int i = 0; i < params.size(); ++i){
+        const int code = params.at(i);
+        if(code == 0) style = TerminalStyle();
+        else if(code == 1) style.flags |= TerminalStyle::Bold;
+        else if(code == 2) style.flags |= TerminalStyle::Faint;
+        else if(code == 3) style.flags |= TerminalStyle::Italic;
+        else if(code == 4) style.flags |= TerminalStyle::Underline;
+        else if(code == 7) style.flags |= TerminalStyle::Inverse;
+        else if(code == 22) style.flags &= ~(TerminalStyle::Bold | TerminalStyle::Faint);
+        else if(code == 23) style.flags &= ~TerminalStyle::Italic;
+        else if(code == 24) style.flags &= ~TerminalStyle::Underline;
+        else if(code == 27) style.flags &= ~TerminalStyle::Inverse;
+        else if(code >= 30 && code <= 37) style.foreground = quint32(code - 30);
+        else if(code == 38) style.foreground = extendedColor(i);
+        else if(code == 39) style.foreground = TerminalStyle::DefaultColor;
+        else if(code >= 40 && code <= 47) style.background = quint32(code - 40);
+        else if(code == 48) style.background = extendedColor(i);
+        else if(code == 49) style.background = TerminalStyle::DefaultColor;
+        else if(code >= 90 && code <= 97) style.foreground = quint32(code - 90 + 8);
+        else if(code >= 100 && code <= 107) style.background = quint32(code - 100 + 8);
+    }
+}
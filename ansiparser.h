@@ -0,0 +1,72 @@
+#ifndef ANSIPARSER_H
+#define ANSIPARSER_H
+
+#include <QByteArray>
+#include <QStringDecoder>
+#include <QVarLengthArray>
+#include "terminalscreen.h"
+
+// turns the raw bytes a shell writes into calls on a TerminalScreen
+// a state machine along the lines of the DEC/xterm parser, fed whatever chunk the pty had ready, so escape
+// sequences (and utf-8 characters) split across reads pick up where they left off. covers what shells, python,
+// less, top and the like actually send: colors (16, 256 and 24 bit), cursor movement, erasing, scroll regions,
+// inserting and deleting, the alternate screen and the private modes that go with them. anything else is
+// parsed and dropped so it never shows up as garbage
+class AnsiParser
+{
+public:
+    explicit AnsiParser(TerminalScreen* screen);
+
+    void feed(const QByteArray& output);
+    void reset();
+
+    // answers to queries like the cursor position report, they have to be written back to the pty
+    QByteArray takeReplies();
+
+    inline bool applicationCursorKeys() const
+    {
+        return cursorKeysMode;
+    }
+    inline bool bracketedPaste() const
+    {
+        return bracketedPasteMode;
+    }
+
+private:
+    enum class State {
+        Ground,
+        Escape,
+        EscapeIntermediate, // ESC ( and friends, one more character and its done
+        Csi,
+        CsiIgnore, // malformed, skipped up to the final byte
+        OscString, // ESC ] up to BEL or ESC '\'
+        IgnoreString // DCS, SOS, PM and APC, up to ESC '\'
+    };
+
+    void process(char32_t character);
+    void executeControl(char32_t control);
+    void escapeDispatch(char32_t final);
+    void csiDispatch(char32_t final);
+    void selectGraphicRendition();
+    void setPrivateMode(int mode, bool on);
+    int param(int index, int fallback) const; // 0 and missing both mean the fallback, like every terminal treats them
+
+private:
+    inline static constexpr int maxParams = 32;
+    inline static constexpr int maxParamValue = 99999; // large enough for any row count, small enough to never overflow
+
+    TerminalScreen* screen; // non-owning
+    QStringDecoder decoder{QStringDecoder::Utf8};
+    char16_t highSurrogate = 0;
+
+    State state = State::Ground;
+    QVarLengthArray<int, maxParams> params;
+    bool paramStarted = false;
+    char32_t privateMarker = 0; // '?' and the like right after CSI
+
+    QByteArray replies;
+    bool cursorKeysMode = false;
+    bool bracketedPasteMode = false;
+};
+
+#endif // ANSIPARSER_H
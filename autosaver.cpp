@@ -0,0 +1,57 @@
+#include "autosaver.h"
+#include "editor.h"
+
+AutoSaver::AutoSaver(QObject* parent) :
+    QObject(parent),
+    currentMode(settings.autoSave())
+{
+    debounce.setSingleShot(true);
+    debounce.setInterval(settings.autoSaveDelay());
+    connect(&debounce, &QTimer::timeout, this, &AutoSaver::saveEdited);
+}
+
+void AutoSaver::watch(editor* openedEditor)
+{
+    connect(openedEditor, &editor::bufferChanged, this, [this, openedEditor]{
+        editorChanged(openedEditor);
+    });
+}
+
+void AutoSaver::editorLeft(editor* previousEditor)
+{
+    if(currentMode != autoSaveType::SaveOnOpenNewFile || previousEditor == nullptr) return;
+    previousEditor->autoSave();
+}
+
+void AutoSaver::setMode(autoSaveType mode)
+{
+    currentMode = mode;
+    settings.setAutoSave(mode);
+
+    if(mode != autoSaveType::SaveAfterDuratoion){
+        debounce.stop();
+        editedEditors.clear();
+    }
+}
+
+void AutoSaver::setDelay(int milliseconds)
+{
+    debounce.setInterval(milliseconds);
+    settings.setAutoSaveDelay(milliseconds);
+}
+
+void AutoSaver::editorChanged(editor* changedEditor)
+{
+    if(currentMode != autoSaveType::SaveAfterDuratoion) return;
+
+    if(!editedEditors.contains(changedEditor)) editedEditors.append(changedEditor);
+    debounce.start(); // restarts the countdown, nothing saves while the user is still typing
+}
+
+void AutoSaver::saveEdited()
+{
+    const QList<QPointer<editor>> toSave = std::exchange(editedEditors, {});
+    for(const QPointer<editor>& edited : toSave){
+        if(edited != nullptr) edited->autoSave();
+    }
+}
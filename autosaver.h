@@ -0,0 +1,48 @@
+#ifndef AUTOSAVER_H
+#define AUTOSAVER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QPointer>
+#include <QList>
+#include <utility>
+#include "settingshelper.h"
+
+class editor;
+
+// saves editors on its own based on the autoSaveType setting
+// SaveAfterDuratoion waits until typing stops for the configured delay (restarting on every edit) and then saves
+// every editor edited since, SaveOnOpenNewFile saves an editor when another file gets opened or switched to.
+// the saves go through editor::autoSave, which skips documents whose text hashes the same as whats on disk
+class AutoSaver : public QObject
+{
+public:
+    explicit AutoSaver(QObject* parent);
+
+    void watch(editor* openedEditor); // starts tracking edits to a newly opened editor
+    void editorLeft(editor* previousEditor); // another file was opened or switched to
+
+    inline autoSaveType mode() const
+    {
+        return currentMode;
+    }
+    void setMode(autoSaveType mode);
+
+    inline int delay() const
+    {
+        return debounce.interval();
+    }
+    void setDelay(int milliseconds);
+
+private:
+    void editorChanged(editor* changedEditor);
+    void saveEdited(); // the debounce ran out
+
+private:
+    SettingsHelper settings;
+    autoSaveType currentMode;
+    QTimer debounce;
+    QList<QPointer<editor>> editedEditors; // edited since the last autosave, closed tabs turn into nullptrs
+};
+
+#endif // AUTOSAVER_H
@@ -0,0 +1,70 @@
+#include "childwatcher.h"
+
+#ifndef _WIN32
+
+#include <QSocketNotifier>
+#include <cerrno>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+ChildWatcher::ChildWatcher(pid_t pid, QObject* parent) :
+    QObject(parent),
+    childPid(pid)
+{
+#if defined(__linux__) && defined(SYS_pidfd_open)
+    pidFd = int(::syscall(SYS_pidfd_open, pid, 0));
+#endif
+
+    if(pidFd >= 0){
+        exitNotifier = new QSocketNotifier(pidFd, QSocketNotifier::Read, this);
+        connect(exitNotifier, &QSocketNotifier::activated, this, &ChildWatcher::check);
+    }
+    else{
+        // older kernels and other unixes
+        pollTimer.setSingleShot(true);
+        pollTimer.setInterval(firstPollInterval);
+        connect(&pollTimer, &QTimer::timeout, this, &ChildWatcher::check);
+        pollTimer.start();
+    }
+}
+
+ChildWatcher::~ChildWatcher()
+{
+    if(pidFd >= 0) ::close(pidFd);
+}
+
+bool ChildWatcher::tryReap()
+{
+    if(reaped) return true;
+
+    int status = 0;
+    pid_t result;
+    do{
+        result = ::waitpid(childPid, &status, WNOHANG);
+    } while(result < 0 && errno == EINTR);
+    if(result == 0) return false;
+
+    // ECHILD means someone else already reaped it, its gone either way
+    reaped = true;
+    delete exitNotifier;
+    exitNotifier = nullptr;
+    pollTimer.stop();
+
+    emit exited(result > 0 && WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+    return true;
+}
+
+void ChildWatcher::check()
+{
+    if(tryReap()) return;
+
+    if(exitNotifier == nullptr){
+        pollTimer.setInterval(qMin(pollTimer.interval() * 2, maxPollInterval));
+        pollTimer.start();
+    }
+}
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef CHILDWATCHER_H
+#define CHILDWATCHER_H
+
+#ifndef _WIN32
+
+#include <QObject>
+#include <QTimer>
+#include <sys/types.h>
+
+class QSocketNotifier;
+
+// tells when a child process exits, and reaps it so it doesnt stay around as a zombie
+// on linux a pidfd becomes readable the moment the process exits, so this is just another socket notifier on
+// the event loop. anywhere else it falls back to checking with waitpid on a timer that backs off while the
+// process keeps running. never touches SIGCHLD, which QProcess already uses for its own children
+class ChildWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    ChildWatcher(pid_t pid, QObject* parent);
+    ~ChildWatcher();
+
+    inline pid_t pid() const
+    {
+        return childPid;
+    }
+
+    bool tryReap(); // true once the process is gone, exited gets emitted either way
+
+signals:
+    void exited(int exitCode); // -1 if it was killed by a signal
+
+private:
+    void check();
+
+private:
+    inline static constexpr int firstPollInterval = 10; // milliseconds, doubling up to the max
+    inline static constexpr int maxPollInterval = 250;
+
+    pid_t childPid;
+    bool reaped = false;
+    int pidFd = -1;
+    QSocketNotifier* exitNotifier = nullptr;
+    QTimer pollTimer;
+};
+
+#endif
+
+#endif // CHILDWATCHER_H
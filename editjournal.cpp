@@ -0,0 +1,222 @@
+#include "editjournal.h"
+#include "journalwriter.h"
+#include "filesaver.h"
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QTextStream>
+#include <QDir>
+#include <QFileInfo>
+#include <optional>
+#include <utility>
+
+namespace {
+
+// the file the way editor::openFile reads it
+std::optional<QString> readFromDisk(const QString& filePath)
+{
+    QFile file(filePath);
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) return std::nullopt;
+    QTextStream in(&file);
+    return in.readAll();
+}
+
+std::optional<EditJournal::Recovery> replay(const QString& journalPath)
+{
+    QFile file(journalPath);
+    if(!file.open(QIODevice::ReadOnly)) return std::nullopt;
+
+    QDataStream in(&file);
+    in.setVersion(EditJournal::streamVersion);
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    QString filePath;
+    QByteArray baseHash;
+    in >> magic >> version >> filePath >> baseHash;
+    if(in.status() != QDataStream::Ok || magic != EditJournal::magic || version != EditJournal::version) return std::nullopt;
+
+    TextBuffer text;
+    bool haveBase = false;
+    bool edited = false;
+
+    // stops at the first record that didnt get fully written before the crash
+    while(!in.atEnd()){
+        quint8 type = 0;
+        in >> type;
+
+        if(type == EditJournal::SnapshotRecord){
+            QString snapshot;
+            in >> snapshot;
+            if(in.status() != QDataStream::Ok) break;
+            text = TextBuffer(snapshot);
+            haveBase = edited = true;
+        }
+        else if(type == EditJournal::ReplaceRecord){
+            qint64 position = 0, removed = 0;
+            QString inserted;
+            in >> position >> removed >> inserted;
+            if(in.status() != QDataStream::Ok) break;
+
+            if(!haveBase){
+                // the edits only make sense on top of the exact text they were made to
+                const std::optional<QString> onDisk = readFromDisk(filePath);
+                if(!onDisk) return std::nullopt;
+                text = TextBuffer(*onDisk);
+                if(FileSaver::contentHash(text) != baseHash) return std::nullopt;
+                haveBase = true;
+            }
+
+            if(position < 0 || removed < 0 || position + removed > text.size()) break;
+            text.replace(position, removed, inserted);
+            edited = true;
+        }
+        else{
+            break;
+        }
+    }
+
+    if(!edited) return std::nullopt;
+    return EditJournal::Recovery{journalPath, filePath, text.toString()};
+}
+
+} // namespace
+
+EditJournal::EditJournal(const QString& filePath, const TextBuffer* buffer, QObject* parent) :
+    QObject(parent),
+    filePath(filePath),
+    buffer(buffer),
+    writer(new JournalWriter)
+{
+    writer->moveToThread(&writerThread);
+    connect(&writerThread, &QThread::finished, writer, &QObject::deleteLater);
+    writerThread.start();
+
+    flushTimer.setSingleShot(true);
+    flushTimer.setInterval(flushDelay);
+    connect(&flushTimer, &QTimer::timeout, this, &EditJournal::flush);
+}
+
+EditJournal::~EditJournal()
+{
+    if(discarded){
+        QMetaObject::invokeMethod(writer, [writer = writer, path = journalPath(filePath)]{
+            writer->remove(path);
+        }, Qt::QueuedConnection);
+    }
+    else{
+        flush();
+    }
+
+    writerThread.quit();
+    writerThread.wait(); // runs whatever was queued before quitting
+}
+
+void EditJournal::start()
+{
+    pending.clear();
+    flushTimer.stop();
+    journalBytes = 0;
+    started = true;
+
+    QMetaObject::invokeMethod(writer, [writer = writer, path = journalPath(filePath), filePath = filePath, base = *buffer]{
+        writer->restart(path, filePath, base);
+    }, Qt::QueuedConnection);
+}
+
+void EditJournal::record(qsizetype position, qsizetype removed, QStringView inserted)
+{
+    if(!started || discarded) return;
+
+    QDataStream out(&pending, QIODevice::Append);
+    out.setVersion(streamVersion);
+    out << quint8(ReplaceRecord) << qint64(position) << qint64(removed) << inserted.toString();
+
+    if(pending.size() > maxBatchBytes) flush();
+    else if(!flushTimer.isActive()) flushTimer.start(); // batches everything typed within the delay into one write
+}
+
+void EditJournal::flush()
+{
+    flushTimer.stop();
+    if(pending.isEmpty()) return;
+
+    journalBytes += pending.size();
+
+    // replaying has to go through every record, once theyre much bigger than the text a snapshot is cheaper
+    if(journalBytes > qMax<qint64>(minCompactBytes, 2 * buffer->size() * qint64(sizeof(char16_t)))){
+        compact();
+        return;
+    }
+
+    QMetaObject::invokeMethod(writer, [writer = writer, records = std::exchange(pending, QByteArray())]{
+        writer->append(records);
+    }, Qt::QueuedConnection);
+}
+
+void EditJournal::compact()
+{
+    if(!started || discarded) return;
+
+    pending.clear(); // already part of the snapshot
+    flushTimer.stop();
+    journalBytes = buffer->size() * qint64(sizeof(char16_t));
+
+    QMetaObject::invokeMethod(writer, [writer = writer, path = journalPath(filePath), filePath = filePath, current = *buffer]{
+        writer->compact(path, filePath, current);
+    }, Qt::QueuedConnection);
+}
+
+void EditJournal::setFilePath(const QString& newFilePath)
+{
+    if(newFilePath == filePath) return;
+
+    QMetaObject::invokeMethod(writer, [writer = writer, path = journalPath(filePath)]{
+        writer->remove(path);
+    }, Qt::QueuedConnection);
+
+    filePath = newFilePath;
+    if(started && !discarded) compact(); // nothing on disk at the new path matches the text yet
+}
+
+void EditJournal::discard()
+{
+    discarded = true;
+    pending.clear();
+    flushTimer.stop();
+}
+
+QByteArray EditJournal::header(const QString& filePath, const QByteArray& baseHash)
+{
+    QByteArray bytes;
+    QDataStream out(&bytes, QIODevice::WriteOnly);
+    out.setVersion(streamVersion);
+    out << magic << version << filePath << baseHash;
+    return bytes;
+}
+
+QString EditJournal::journalDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/journal";
+}
+
+QString EditJournal::journalPath(const QString& filePath)
+{
+    // one journal per file, named after a hash of its path so any path makes a valid file name
+    const QByteArray name = QCryptographicHash::hash(QFileInfo(filePath).absoluteFilePath().toUtf8(), QCryptographicHash::Md5).toHex();
+    return journalDirectory() + "/" + QString::fromLatin1(name) + ".journal";
+}
+
+QList<EditJournal::Recovery> EditJournal::recoverAll()
+{
+    QList<Recovery> recoveries;
+
+    const QDir directory(journalDirectory());
+    const QStringList journals = directory.entryList(QStringList() << "*.journal", QDir::Files);
+    for(const QString& name : journals){
+        const QString path = directory.filePath(name);
+        std::optional<Recovery> recovery = replay(path);
+        if(recovery) recoveries.append(std::move(*recovery));
+        else QFile::remove(path); // nothing in it worth restoring
+    }
+    return recoveries;
+}
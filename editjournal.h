@@ -0,0 +1,78 @@
+#ifndef EDITJOURNAL_H
+#define EDITJOURNAL_H
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <QDataStream>
+#include "textbuffer.h"
+
+class JournalWriter;
+
+// append only log of every edit made to an editor since its file was last saved, so unsaved work survives a crash
+// edits are serialized as they happen and written out in batches by a JournalWriter on its own thread. once the log
+// grows past a couple of times the document size it gets compacted into a single snapshot of the text.
+// the journal is removed when the editor closes normally, so any journal left on disk at startup is from a crash
+//
+// format (QDataStream): header of magic, version, the file's path and the hash of the text on disk the edits apply to,
+// then records of a type byte followed by either position, removed count and inserted text, or a full text snapshot
+class EditJournal : public QObject
+{
+public:
+    EditJournal(const QString& filePath, const TextBuffer* buffer, QObject* parent);
+    ~EditJournal(); // writes out whatever is still batched, and removes the file if discard was called
+
+    void start(); // the buffer matches the file on disk now, any older journal for it is thrown out
+    void record(qsizetype position, qsizetype removed, QStringView inserted);
+    void compact(); // replaces the log with a snapshot of the current text
+    void setFilePath(const QString& filePath); // save as, the journal moves along with the file
+    void discard(); // closed normally, nothing to recover
+
+    // a journal left behind by a crash, with the text it replays to
+    struct Recovery
+    {
+        QString journalPath;
+        QString filePath;
+        QString text;
+    };
+
+    // replays every journal in the journal directory, ones that cant be replayed (the file changed on disk since,
+    // or nothing was ever edited) are removed. the rest are left for the caller to remove or reopen
+    static QList<Recovery> recoverAll();
+
+    static QString journalDirectory();
+    static QString journalPath(const QString& filePath);
+
+public: // the file format, shared with JournalWriter
+    enum RecordType : quint8 {
+        ReplaceRecord = 1,
+        SnapshotRecord = 2
+    };
+    inline static constexpr quint32 magic = 0x54454A31; // "TEJ1"
+    inline static constexpr quint16 version = 1;
+    inline static constexpr QDataStream::Version streamVersion = QDataStream::Qt_6_0;
+
+    static QByteArray header(const QString& filePath, const QByteArray& baseHash);
+
+private:
+    void flush(); // hands the batched records to the writer
+
+private:
+    inline static constexpr int flushDelay = 200; // milliseconds edits are batched before being written
+    inline static constexpr qsizetype maxBatchBytes = 1024 * 1024; // written right away past this
+    inline static constexpr qint64 minCompactBytes = 4 * 1024 * 1024;
+
+    QString filePath;
+    const TextBuffer* buffer; // the editors piece table (non-owning)
+
+    QThread writerThread;
+    JournalWriter* writer;
+
+    QByteArray pending; // serialized records waiting for the next flush
+    QTimer flushTimer;
+    qint64 journalBytes = 0; // roughly how big the file on disk is, for deciding when to compact
+    bool started = false;
+    bool discarded = false;
+};
+
+#endif // EDITJOURNAL_H
@@ -7,47 +7,31 @@
 #include <QFileDialog>
 #include <QTextStream>
 #include <QMainWindow>
+#include "fileloader.h"
+#include "filesaver.h"
+#include "editjournal.h"
+#include <QCoreApplication>
+#include <utility>
 
 editor::editor(QTabWidget *parent, QMainWindow* mainWindow)
     : QWidget{parent},
     textEdit(new QPlainTextEdit(this)),
-    lineNumberTextEdit(new QPlainTextEdit(this)),
+    lineNumberArea(new LineNumberArea(textEdit, this)),
+    selectionLayers(textEdit),
+    multiCursor(new MultiCursor(textEdit, &selectionLayers, this)),
     layout(new QHBoxLayout(this)),
     parent(parent),
     mainWindow(mainWindow),
-    searchAndReplace(std::make_unique<SearchAndReplace>(this->textEdit)),
-    syntaxHighlighter(std::make_unique<SyntaxHighlighter>(this->textEdit->document()))
+    searchAndReplace(std::make_unique<SearchAndReplace>(this->textEdit, &this->buffer, &this->selectionLayers, this->multiCursor)),
+    syntaxHighlighter(std::make_unique<SyntaxHighlighter>(this->textEdit, &this->buffer)),
+    progressBar(new QProgressBar(this))
 // reminder** (The order they are initialized here does not matter, what matters is the order they are declared in the header
 {
     font.setFixedPitch(true);
     // storing it into a single widget
     // basically reapplying all the values from the .ui file for the old widgets
     // (translating the markup to code here)
-    lineNumberTextEdit->setMinimumSize(20, 40);
-    lineNumberTextEdit->setMaximumSize(50, 16777215);
-    lineNumberTextEdit->setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Expanding);
-    // Has lines setting horizontal and vertical stretch to 0 within this policy, not sure of code alternative
-
-    lineNumberTextEdit->setFont(font);
-    // usually underlined, removing indefinetly
-
-    lineNumberTextEdit->setFocusPolicy(Qt::NoFocus);
-    lineNumberTextEdit->setContextMenuPolicy(Qt::NoContextMenu);
-    lineNumberTextEdit->setInputMethodHints(Qt::ImhNone);
-
-    lineNumberTextEdit->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-    lineNumberTextEdit->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-
-    lineNumberTextEdit->setSizeAdjustPolicy(QAbstractScrollArea::SizeAdjustPolicy::AdjustToContents);
-    lineNumberTextEdit->setReadOnly(true);
-    lineNumberTextEdit->setTextInteractionFlags(Qt::NoTextInteraction);
-
-    lineNumberTextEdit->viewport()->setCursor(Qt::ArrowCursor); // stops cursor from changing when hovering over line number
-    lineNumberTextEdit->setStyleSheet("QPlainTextEdit {background-color: black;}");
-    lineNumberTextEdit->verticalScrollBar()->hide();
-
-    lineNumberTextEdit->setLineWrapMode(QPlainTextEdit::NoWrap);
-
+    lineNumberArea->setFont(font);
 
     textEdit->setMinimumSize(40, 40);
     textEdit->setFont(font);
@@ -61,279 +45,542 @@ editor::editor(QTabWidget *parent, QMainWindow* mainWindow)
     textEdit->setTabStopDistance(4 * spaceWidth); // tab is 4 spaces, (currently it sets distance not 4 space presses)
 
 
-    connect(lineNumberTextEdit->verticalScrollBar(), &QScrollBar::valueChanged, this, &editor::synchronizeScrollBars);
-    connect(textEdit->verticalScrollBar(), &QScrollBar::valueChanged, this, &editor::synchronizeScrollBars);
-    // connects the scroll bars of the text box the user types in with the line number text
+    progressBar->setFixedSize(160, 16);
+    progressBar->setTextVisible(false);
+    progressBar->hide();
+
+    compactor.setMaxThreadCount(1);
 
     connect(textEdit, &QPlainTextEdit::modificationChanged, this, &editor::updateTabTitle);
 
-    connect(textEdit, &QPlainTextEdit::blockCountChanged, this, &editor::calculateNumberOfLines);
+    connect(textEdit->document(), &QTextDocument::contentsChange, this, &editor::syncBuffer);
+    connect(this, &editor::bufferChanged, multiCursor, &MultiCursor::documentChanged); // an edit from anywhere else drops the extra carets
 
     // to fill out the entire tab like in the original layout
-    layout->addWidget(lineNumberTextEdit);
+    layout->addWidget(lineNumberArea);
     layout->addWidget(textEdit);
     this->setLayout(layout);
 }
 
 editor::~editor()
 {
-    if(unsavedChanges()){
-        std::string text = "File (" +  this->currentFile.toStdString() +") has some unsaved changes, would you like to save them?";
-        auto saved = QMessageBox::question(mainWindow,
-                                           tr("Unsaved Changes"),
-                                           tr(text.c_str()),
-                                           QMessageBox::Save | QMessageBox::Discard, QMessageBox::Save);
-        if(saved == QMessageBox::Save){
-            saveFile();
-        }
+    compactor.waitForDone(); // the task only has its own snapshot, but it queues a call back onto this
+    if(evicted) return; // never evicted while loading or saving, and the unsaved text was kept elsewhere
+
+    if(isLoading()){
+        // the document only holds part of the file, just stop the loader
+        loaderThread->quit();
+        loaderThread->wait();
+        // recovered or evicted text that was waiting for the load is still unsaved work though
+        if(!pendingRestore.isNull()) saveOrDiscardText(mainWindow, currentFile, pendingRestore);
+        return;
+    }
 
+    if(isSaving()){
+        // let the write finish, then take its result now since the event loop wont get to it anymore
+        saveAgain = false;
+        saverThread->quit();
+        saverThread->wait();
+        QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
     }
+
+    // a failed save keeps the journal, its the only copy of the text left and gets offered again on the next start
+    if(unsavedChanges() && askToSave(mainWindow, currentFile) && !saveFileNow()) return;
+
+    // either saved or thrown away on purpose, theres nothing left to recover
+    if(journal != nullptr) journal->discard();
 }
 
+bool editor::askToSave(QWidget* dialogParent, const QString& filePath)
+{
+    std::string text = "File (" +  filePath.toStdString() +") has some unsaved changes, would you like to save them?";
+    auto saved = QMessageBox::question(dialogParent,
+                                       tr("Unsaved Changes"),
+                                       tr(text.c_str()),
+                                       QMessageBox::Save | QMessageBox::Discard, QMessageBox::Save);
+    return saved == QMessageBox::Save;
+}
 
-void editor::synchronizeScrollBars()
+void editor::saveOrDiscardText(QWidget* dialogParent, const QString& filePath, const QString& text)
 {
-    int textEditScrollValue = textEdit->verticalScrollBar()->value();
-    int lineNumScrollValue = lineNumberTextEdit->verticalScrollBar()->value();
+    if(askToSave(dialogParent, filePath)){
+        const QString errorMessage = FileSaver::write(filePath, TextBuffer(text));
+        if(!errorMessage.isEmpty()){
+            QMessageBox::warning(dialogParent, tr("Warning"), errorMessage);
+            return;
+        }
+    }
+    QFile::remove(EditJournal::journalPath(filePath));
+}
 
-    if (textEditScrollValue != lineNumScrollValue) {
-        lineNumberTextEdit->verticalScrollBar()->setValue(textEditScrollValue);
-        textEdit->verticalScrollBar()->setValue(textEditScrollValue);
+
+void editor::commentLines()
+{
+    // how commenting out multiple lines works
+    // multiple lines selected -> if they are all comments it uncomments, otherwise every line gets another #
+    // with no selection it toggles the line the cursor is on
+    const QTextCursor textCursor = textEdit->textCursor();
+    QTextDocument* document = textEdit->document();
+
+    const QTextBlock first = document->findBlock(textCursor.selectionStart());
+    QTextBlock last = document->findBlock(textCursor.selectionEnd());
+    if(last != first && textCursor.selectionEnd() == last.position()) last = last.previous(); // ending at the very start of a line doesnt take it in
+
+    // one character looked at per line, nothing gets copied out of the document
+    bool everyLineStartsWithComment = true;
+    for(QTextBlock block = first; block.isValid(); block = block.next()){
+        if(document->characterAt(block.position()) != commentSymbol){
+            everyLineStartsWithComment = false;
+            break;
+        }
+        if(block == last) break;
     }
+
+    setLinesCommented(first, last, !everyLineStartsWithComment);
 }
 
-void editor::calculateNumberOfLines(int newBlockCount)
+void editor::setLinesCommented(const QTextBlock& first, const QTextBlock& last, bool commented)
 {
-    if(previousNumberOfLines == 0) {
-        return; // so it doesn't append on startup just a singular line with the full amount
+    const QTextCursor before = textEdit->textCursor();
+    const int firstPosition = first.position(); // every edit is at or after this, so it doesnt move
+
+    // only the # at the start of each line changes, as one undo step, so the rest of the lines keep their formats
+    // and highlighting, and the piece table gets one change covering the range instead of one per line
+    QTextCursor edit(textEdit->document());
+    edit.beginEditBlock();
+    for(QTextBlock block = first; block.isValid(); block = block.next()){
+        edit.setPosition(block.position());
+        if(commented) edit.insertText(QString(commentSymbol));
+        else if(textEdit->document()->characterAt(block.position()) == commentSymbol) edit.deleteChar();
+        if(block == last) break;
     }
+    edit.endEditBlock();
+
+    // the text edits cursor moved along with the edits, except one that was at the start of the first line got
+    // pushed past its new #, put it back so a selection still covers whole lines
+    if(!before.hasSelection()) return;
+    QTextCursor after = textEdit->textCursor();
+    const int anchor = before.anchor() == firstPosition ? firstPosition : after.anchor();
+    const int position = before.position() == firstPosition ? firstPosition : after.position();
+    after.setPosition(anchor);
+    after.setPosition(position, QTextCursor::KeepAnchor);
+    textEdit->setTextCursor(after);
+}
 
-    if(previousNumberOfLines > newBlockCount) {
-        // they deleted a line, also works for multiple lines since it does a loop
-        int linesToRemove = previousNumberOfLines - newBlockCount;
-        QTextCursor cursor(lineNumberTextEdit->textCursor());
-        cursor.movePosition(QTextCursor::End, QTextCursor::MoveAnchor);
+void editor::saveFile()
+{
+    // Dont think this is applicable anymore, wont have anything to save
+    /// if(currentFile.isEmpty()) {
+    ///     saveAs();  // on cases where option is available with no file, calls to save as
+    ///     return;
+    /// }
 
-        for (int i = 0; i < linesToRemove; i++){
-            cursor.movePosition(QTextCursor::StartOfLine, QTextCursor::KeepAnchor);
-            cursor.removeSelectedText();
-            cursor.deletePreviousChar();
-        }
+    startSave(false);
+}
 
-    }
-    else{
-        // they added one or more lines, append the new line numbers
-        int linesToAdd = newBlockCount - previousNumberOfLines;
-        for (int i = 1; i <= linesToAdd; i++){
-            lineNumberTextEdit->appendPlainText(QString::number(previousNumberOfLines + i));
-        }
-    }
+void editor::autoSave()
+{
+    if(isLoading() || currentFile.isEmpty()) return;
+    if(buffer.revision() == savedRevision) return; // nothing typed since the last save, not even worth hashing
 
-    previousNumberOfLines = newBlockCount;
-    // updates the previous line numbers variable so that it can reflect later on what type of line change was done
+    startSave(true);
 }
 
-void editor::createLineNumbersOnFileOpen(const int lineNumbers)
+void editor::startSave(bool skipIfUnchanged)
 {
+    if(isLoading()) return; // saving now would truncate the file to whatever has streamed in so far
+    if(isSaving()){
+        saveAgain = true; // whats being written is already out of date, write again once its done
+        return;
+    }
 
-    lineNumberTextEdit->clear(); // clears the text in case user opens another file
+    // small files save before the bar would even paint, only show it when theres something to watch
+    const bool showProgress = buffer.size() > FileLoader::largeFileThreshold;
+    if(showProgress){
+        progressBar->setRange(0, 1000);
+        progressBar->setValue(0);
+        progressBar->show();
+    }
+
+    saverThread = new QThread(this);
+    // copying the buffer is the snapshot, typing can go on while it writes
+    fileSaver = new FileSaver(currentFile, buffer, skipIfUnchanged ? savedContentHash : QByteArray());
+    fileSaver->moveToThread(saverThread);
 
-    for(int thisLineNumber = 1; thisLineNumber <= lineNumbers; thisLineNumber++){
+    connect(saverThread, &QThread::started, fileSaver, &FileSaver::save);
+    connect(saverThread, &QThread::finished, fileSaver, &QObject::deleteLater);
 
-        lineNumberTextEdit->appendPlainText(QString::number(thisLineNumber));
+    if(showProgress){
+        connect(fileSaver, &FileSaver::progress, this, [this](qint64 written, qint64 total){
+            progressBar->setValue(total > 0 ? static_cast<int>(written * 1000 / total) : 1000);
+        });
     }
+    connect(fileSaver, &FileSaver::saved, this, [this](quint64 revision, const QByteArray& contentHash){
+        savedRevision = revision;
+        savedContentHash = contentHash;
+        // anything typed after the snapshot was taken still isnt on disk
+        if(revision == buffer.revision()) textEdit->document()->setModified(false);
+
+        // the journal only has to cover whats not on disk, which is nothing unless typing went on during the save
+        if(journal != nullptr){
+            if(revision == buffer.revision()) journal->start();
+            else journal->compact();
+        }
+        finishSaving();
+    });
+    connect(fileSaver, &FileSaver::failed, this, [this](const QString& errorMessage){
+        saveAgain = false;
+        finishSaving();
+        QMessageBox::warning(mainWindow, tr("Warning"), errorMessage);
+    });
+
+    saverThread->start();
 }
 
-void editor::commentLines()
+void editor::finishSaving()
 {
-    /* this is a very uneleagant solution though, it modifies the users current cursor, and
-     * if the document was unmodified, it disregards and isModified becomes true (just cause the colors changed)
-     */
-    auto textCursor = textEdit->textCursor();
-    // how commenting out multiple lines works
-    // multiple lines selected -> if they are all comments it uncomments
-    // otherwise it adds another comment symbol, though this makes more sense with "//" coments and not "#"
-    // additionally, if the user has no text selected, the comment toggle affects the start of the line,
-    // otherwise it goes by each line of the selection
-
-    if(textCursor.hasSelection()){
-        // const int startIndex = textCursor.selectionStart();
-        QString text = textCursor.selection().toPlainText();
-
-        QStringList textSplit = text.split("\n");
-        // qDebug() << textSplit.at(2);
-        bool everyLineStartsWithComment = true; // assumes every line is a comment, then loops to check, if one doesnt, it breaks
-        for(QString &line : textSplit){
-            if(!line.startsWith("#")){
-                everyLineStartsWithComment = false;
-                break;
-            }
-        }
-        if(everyLineStartsWithComment) removeComments();
-        else addComments();
+    saverThread->quit();
+    saverThread->wait();
+    saverThread->deleteLater();
+    saverThread = nullptr;
+    fileSaver = nullptr; // deleted along with the thread finishing
+
+    if(!isLoading()) progressBar->hide();
+
+    // updateWindowTitle();
+    updateTabTitle();
 
+    if(saveAgain){
+        saveAgain = false;
+        saveFile();
     }
-    else{
+}
 
-        QString currentLine = textCursor.block().text();
-        if(currentLine.startsWith("#")) {
-            removeComments();
-        }
-        else {
-            addComments();
-        }
+bool editor::saveFileNow()
+{
+    const QString errorMessage = FileSaver::write(currentFile, buffer);
+    if(!errorMessage.isEmpty()){
+        QMessageBox::warning(mainWindow, tr("Warning"), errorMessage);
+        return false;
     }
+    savedRevision = buffer.revision();
+    textEdit->document()->setModified(false);
+    return true;
 }
 
-void editor::addComments()
+void editor::saveAs()
 {
-    auto textCursor = textEdit->textCursor();
-    // case when not every line is a comment
+    if(isLoading()) return;
 
-    // original cursor positions to revert
-    int start = textCursor.selectionStart();
-    // int end = textCursor.selectionEnd();
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save As"));
+    if (fileName.isEmpty()) {
+        return;  // If the user cancels the save dialog, do nothing.
+    }
 
-    QString text = textCursor.selection().toPlainText();
-    QStringList textSplit = text.split("\n");
-    QStringList finalText;
-    const QChar commentSymbol = '#';
-    if(textCursor.hasSelection()){
+    currentFile = fileName;
+    if(journal != nullptr) journal->setFilePath(fileName);
+    emit fileRenamed(fileName);
+    // TODO: reenable save in mainwindow file
+    // this->ui->actionSave->setEnabled(true); // can save now since a file is selected
 
+    saveFile(); // a save still running for the old name finishes first, then this one writes to the new name
 
-        for(QString& line : textSplit){
-            finalText << commentSymbol + line;
-        }
-        // turns the list back to a single string
-        QString commentedText = finalText.join("\n");
+    // updateWindowTitle();
+    updateTabTitle();
+}
 
-        // replaces text
-        textCursor.insertText(commentedText);
+void editor::openFile(QFile& file)
+{
+    currentFile = file.fileName();
+    loadTimer.start();
+    lastLoad = LoadInfo{file.size(), QString(), -1};
 
-        // brings cursor back to original position
-        textCursor.setPosition(start);
-        textCursor.setPosition(start + commentedText.length(), QTextCursor::KeepAnchor);
-        textEdit->setTextCursor(textCursor);
+    if(file.size() > FileLoader::largeFileThreshold){
+        loadLargeFile();
+        return;
     }
 
-    else{
-        textCursor.movePosition(QTextCursor::StartOfLine);
-        textCursor.insertText("#");
-    }
+    QTextStream in(&file);
+    QString text = in.readAll();
+    lastLoad.encoding = QString::fromLatin1(QStringConverter::nameForEncoding(in.encoding()));
+    textEdit->setPlainText(text);
+    lastLoad.milliseconds = loadTimer.elapsed();
+
+    savedRevision = buffer.revision();
+    savedContentHash = FileSaver::contentHash(buffer); // lets autosave tell when edits get undone back to this
+    textEdit->document()->setModified(false);
+
+    journal = new EditJournal(currentFile, &buffer, this);
+    journal->start();
+    // it seems that highlighting the text emits the textChanged signal (which caused the save question to always go off)
+
+    emit loaded();
+
 }
 
+void editor::loadLargeFile()
+{
+    textEdit->clear();
+    buffer.clear();
+    textEdit->setReadOnly(true); // no typing into a document thats still being filled
+    textEdit->document()->setUndoRedoEnabled(false); // streaming the file in shouldnt be undoable
+
+    progressBar->setRange(0, 0); // busy indicator until the loader knows the size
+    progressBar->show();
+
+    loaderThread = new QThread(this);
+    fileLoader = new FileLoader(currentFile);
+    fileLoader->moveToThread(loaderThread);
+
+    connect(loaderThread, &QThread::started, fileLoader, &FileLoader::open);
+    connect(loaderThread, &QThread::finished, fileLoader, &QObject::deleteLater);
+
+    connect(fileLoader, &FileLoader::opened, this, [this](qint64 totalBytes, const QString& encoding){
+        lastLoad.encoding = encoding;
+        progressBar->setRange(0, 1000); // permille, a 64 bit byte count doesnt fit the int range
+        progressBar->setValue(0);
+        loadTotalBytes = totalBytes;
+        QMetaObject::invokeMethod(fileLoader, &FileLoader::readNextChunk, Qt::QueuedConnection);
+    });
+    connect(fileLoader, &FileLoader::chunkReady, this, &editor::appendLoadedChunk);
+    connect(fileLoader, &FileLoader::finished, this, &editor::finishLoading);
+    connect(fileLoader, &FileLoader::failed, this, [this](const QString& errorMessage){
+        stopLoader();
+        // nothing here counts as unsaved, so neither an autosave meanwhile nor the destructor writes it out
+        savedRevision = buffer.revision();
+        textEdit->document()->setModified(false);
+        QMessageBox::warning(mainWindow, tr("Warning"), errorMessage);
+        // none or only part of the file made it in, saving or autosaving that would cut the real file short, so the
+        // tab goes. text waiting to be restored is still in its journal on disk, which is left for the next start
+        parent->removeTab(parent->indexOf(this));
+        deleteLater();
+    });
+
+    loaderThread->start();
+}
 
-void editor::removeComments()
+void editor::appendLoadedChunk(const QString& text, qint64 bytesRead)
 {
-    auto textCursor = textEdit->textCursor();
-    if (textCursor.hasSelection()) {
-        int start = textCursor.selectionStart();
-        QString text = textCursor.selection().toPlainText();
-        QStringList textSplit = text.split("\n");
-        QStringList finalText;
-        const QChar commentSymbol = '#';
-        for(QString& line : textSplit){
-            if (line.startsWith(commentSymbol)) {
-                line.remove(0, 1);
-            }
-            finalText << line;
-        }
-        QString uncommentedText = finalText.join("\n");
-        textCursor.insertText(uncommentedText);
-        textCursor.setPosition(start);
-        textCursor.setPosition(start + uncommentedText.length(), QTextCursor::KeepAnchor);
-        textEdit->setTextCursor(textCursor);
+    // ask for the next chunk before inserting this one, so the loader decodes while the document lays this one out
+    QMetaObject::invokeMethod(fileLoader, &FileLoader::readNextChunk, Qt::QueuedConnection);
+
+    const bool firstChunk = textEdit->document()->isEmpty();
+
+    // the chunk goes into the buffer directly, syncBuffer skips changes while loading
+    buffer.insert(buffer.size(), text);
+
+    QTextCursor cursor(textEdit->document());
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText(text);
+
+    if(firstChunk){
+        textEdit->moveCursor(QTextCursor::Start); // the insert pushes the view cursor along, keep the top of the file on screen
     }
-    else {
-        textCursor.movePosition(QTextCursor::StartOfLine);
-        QString currentLine = textCursor.block().text();
 
-        if (currentLine.startsWith("#")) {
-            textCursor.deleteChar();
-        }
+    if(loadTotalBytes > 0){
+        progressBar->setValue(static_cast<int>(bytesRead * 1000 / loadTotalBytes));
     }
 }
 
-void editor::saveFile()
+void editor::stopLoader()
 {
-    // Dont think this is applicable anymore, wont have anything to save
-    /// if(currentFile.isEmpty()) {
-    ///     saveAs();  // on cases where option is available with no file, calls to save as
-    ///     return;
-    /// }
+    loaderThread->quit();
+    loaderThread->wait();
+    loaderThread->deleteLater();
+    loaderThread = nullptr;
+    fileLoader = nullptr; // deleted along with the thread finishing
+    progressBar->hide();
+}
 
-    try {
+void editor::finishLoading(const QByteArray& contentHash)
+{
+    stopLoader();
 
-        QFile file(currentFile);
-        if(!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-            QString errorMessage{QString("Unable to Save File ") + file.errorString()};
-            QMessageBox::warning(mainWindow,
-                                 tr("Warning"),
-                                 tr(errorMessage.toStdString().c_str())
-                                 );
-            return;
-        }
-        QString text = getText();
-        QTextStream out(&file);
-        out << text;
+    textEdit->document()->setUndoRedoEnabled(true);
+    textEdit->setReadOnly(false);
 
-        file.close();
-        textEdit->document()->setModified(false);
+    savedRevision = buffer.revision();
+    savedContentHash = contentHash; // worked out by the loader as it went, same as openFile does for small files
+    textEdit->document()->setModified(false);
+
+    journal = new EditJournal(currentFile, &buffer, this);
+    journal->start();
 
-        // updateWindowTitle();
-        updateTabTitle();
+    lastLoad.milliseconds = loadTimer.elapsed();
+    emit loaded();
 
+    if(!pendingRestore.isNull()){
+        restoreText(std::exchange(pendingRestore, QString()));
     }
-    catch (const std::exception &e) {
-        QMessageBox::warning(mainWindow,
-                             tr("Warning"),
-                             tr(e.what())
-                             );
+    if(pendingLine >= 0){
+        goToLine(std::exchange(pendingLine, -1), pendingColumn, pendingLength);
+    }
+    if(pendingViewState.has_value()){
+        restoreViewState(*std::exchange(pendingViewState, std::nullopt));
     }
 }
 
+void editor::restoreText(const QString& text)
+{
+    if(isLoading()){
+        pendingRestore = text; // put back once the file is fully in
+        return;
+    }
 
-void editor::saveAs()
+    // an edit instead of setPlainText, so undo goes back to the file as its saved
+    QTextCursor cursor(textEdit->document());
+    cursor.select(QTextCursor::Document);
+    cursor.insertText(text);
+}
+
+void editor::goToLine(int line, int column, int length)
 {
-    QString fileName = QFileDialog::getSaveFileName(this, tr("Save As"));
-    if (fileName.isEmpty()) {
-        return;  // If the user cancels the save dialog, do nothing.
+    if(isLoading()){
+        pendingLine = line;
+        pendingColumn = column;
+        pendingLength = length;
+        return;
     }
 
-    QFile file(fileName);
-    if (!file.open(QFile::WriteOnly | QFile::Text)) {
-        QMessageBox::warning(mainWindow, tr("Warning"), "Can Not Save File: " + file.errorString());
+    const QTextBlock block = textEdit->document()->findBlockByNumber(line);
+    if(!block.isValid()) return; // the file changed since, the line isnt there anymore
+
+    const int lineEnd = block.position() + block.length() - 1;
+    QTextCursor cursor(block);
+    cursor.setPosition(qMin(block.position() + column, lineEnd));
+    cursor.setPosition(qMin(cursor.position() + length, lineEnd), QTextCursor::KeepAnchor);
+
+    textEdit->setTextCursor(cursor);
+    textEdit->centerCursor();
+    textEdit->setFocus();
+}
+
+editor::ViewState editor::viewState() const
+{
+    const QTextCursor cursor = textEdit->textCursor();
+    return ViewState{cursor.anchor(), cursor.position(), textEdit->verticalScrollBar()->value(), textEdit->horizontalScrollBar()->value()};
+}
+
+void editor::restoreViewState(const ViewState& state)
+{
+    if(isLoading()){
+        pendingViewState = state;
         return;
     }
 
-    currentFile = fileName;
-    // TODO: reenable save in mainwindow file
-    // this->ui->actionSave->setEnabled(true); // can save now since a file is selected
+    // the file could have changed on disk since, positions past the end just go to the end
+    const int end = textEdit->document()->characterCount() - 1;
+    QTextCursor cursor(textEdit->document());
+    cursor.setPosition(qBound(0, state.anchor, end));
+    cursor.setPosition(qBound(0, state.position, end), QTextCursor::KeepAnchor);
+    textEdit->setTextCursor(cursor);
+    textEdit->verticalScrollBar()->setValue(state.verticalScroll);
+    textEdit->horizontalScrollBar()->setValue(state.horizontalScroll);
+}
 
-    QTextStream out(&file);
-    QString currentText = textEdit->toPlainText();
-    out << currentText;  // sets the text content of that file equal to the current text
-    file.close();
+qint64 editor::memoryEstimate() const
+{
+    return qint64(textEdit->document()->characterCount()) * estimatedBytesPerCharacter;
+}
 
-    // updateWindowTitle();
-    updateTabTitle();
+void editor::syncBuffer(int from, int charsRemoved, int charsAdded)
+{
+    if(isLoading()) return; // appendLoadedChunk already put the chunk in the buffer
+    if(batchedEdit) return; // recordBatchedEdit already put each of the edits in
+
+    const qsizetype oldLength = buffer.size();
+    const qsizetype newLength = textEdit->document()->characterCount() - 1; // minus the paragraph separator every document ends with
+
+    // setPlainText reports the trailing separator in both counts, so work out the real change from the lengths
+    const qsizetype removed = qMin<qsizetype>(charsRemoved, oldLength - from);
+    const qsizetype added = newLength - (oldLength - removed);
+
+    if(from > oldLength || removed < 0 || added < 0 || added > charsAdded){
+        const QString text = textEdit->toPlainText();
+        replaceInBuffer(0, oldLength, text); // lost track somehow, start over from the document
+        if(journal != nullptr) journal->record(0, oldLength, text);
+        emit bufferChanged();
+        return;
+    }
+
+    QString inserted = documentText(from, added);
+
+    // format only changes (highlighting, search colors) come through as the same text removed and added
+    if(removed == added && buffer.matches(from, inserted)) return;
+
+    replaceInBuffer(from, removed, inserted);
+    if(journal != nullptr) journal->record(from, removed, inserted);
+    if(buffer.needsCompacting()) compactBuffer();
+    emit bufferChanged();
 }
 
-void editor::openFile(QFile& file)
+void editor::beginBatchedEdit()
 {
-    currentFile = file.fileName();
+    batchedEdit = true;
+    batchChanged = false;
+}
 
-    QTextStream in(&file);
-    QString text = in.readAll();
-    textEdit->setPlainText(text);
+void editor::recordBatchedEdit(int position, int removed, int added)
+{
+    if(isLoading() || (removed == 0 && added == 0)) return;
 
-    previousNumberOfLines = this->textEdit->blockCount();
-    // the number of lines for the line counter, also stores the variable to see if the change was line added or removed
-    createLineNumbersOnFileOpen(previousNumberOfLines);
+    const QString inserted = documentText(position, added);
+    replaceInBuffer(position, removed, inserted);
+    if(journal != nullptr) journal->record(position, removed, inserted);
+    batchChanged = true;
+}
 
-    textEdit->document()->setModified(false);
-    // it seems that highlighting the text emits the textChanged signal (which caused the save question to always go off)
+void editor::endBatchedEdit()
+{
+    batchedEdit = false;
+    if(!batchChanged) return;
 
+    if(buffer.needsCompacting()) compactBuffer();
+    emit bufferChanged(); // once for the whole batch
+}
+
+void editor::replaceInBuffer(qsizetype position, qsizetype removed, const QString& inserted)
+{
+    buffer.replace(position, removed, inserted);
+    // a compaction running on an older snapshot gets these replayed onto its result
+    if(compactingBuffer) editsSinceCompaction.append(BufferEdit{position, removed, inserted});
+}
+
+void editor::compactBuffer()
+{
+    if(compactingBuffer) return;
+    compactingBuffer = true;
+
+    compactor.start([this, snapshot = buffer]{
+        const std::shared_ptr<TextBuffer> merged = std::make_shared<TextBuffer>(snapshot.compacted());
+        QMetaObject::invokeMethod(this, [this, merged]{
+            compactingBuffer = false;
+
+            // whatever was typed while it ran goes on top, a few small pieces instead of throwing the merge away
+            // and copying the whole text again on the next edit
+            for(const BufferEdit& edit : std::exchange(editsSinceCompaction, {})){
+                merged->replace(edit.position, edit.removed, edit.inserted);
+            }
+            // the same edits move the revision the same way, so this only fails if the buffer changed some other
+            // way meanwhile (a reload clearing it), then theres nothing worth keeping
+            if(merged->revision() == buffer.revision()) buffer = std::move(*merged);
+        }, Qt::QueuedConnection);
+    });
+}
+
+QString editor::documentText(int position, int length) const
+{
+    if(length == 0) return QString();
+
+    QTextCursor cursor(textEdit->document());
+    cursor.setPosition(position);
+    cursor.setPosition(position + length, QTextCursor::KeepAnchor);
+
+    // selectedText uses unicode separators between blocks, the buffer holds what toPlainText would return
+    QString text = cursor.selectedText();
+    text.replace(QChar::ParagraphSeparator, u'\n');
+    text.replace(QChar::Nbsp, u' ');
+    return text;
 }
 
 void editor::updateTabTitle()
@@ -363,6 +610,10 @@ void editor::resizeEvent(QResizeEvent* e)
     const int margin = 10; // Margin from the top and right edges
     QPoint topRight = textEdit->rect().topRight();
     searchAndReplace->move(topRight.x()- searchAndReplace->width() - margin, topRight.y() + margin);
+
+    // loading progress goes in the bottom right, same margin
+    QPoint bottomRight = textEdit->geometry().bottomRight();
+    progressBar->move(bottomRight.x() - progressBar->width() - margin, bottomRight.y() - progressBar->height() - margin);
 }
 
 void editor::keyPressEvent(QKeyEvent *event)
@@ -5,20 +5,64 @@
 #include <QPlainTextEdit>
 #include <QHBoxLayout>
 #include <QTabWidget>
+#include <QProgressBar>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QTextBlock>
 #include "searchandreplace.h"
 #include "syntaxhighlighter.h"
+#include "textbuffer.h"
+#include "linenumberarea.h"
+#include "selectionlayers.h"
+#include "multicursor.h"
+#include <optional>
+
+class FileLoader;
+class FileSaver;
+class EditJournal;
 
 class editor : public QWidget
 {
     Q_OBJECT
 public:
+    // where the tab was left, kept when the editor is evicted so it comes back the same
+    struct ViewState
+    {
+        int anchor = 0;
+        int position = 0;
+        int verticalScroll = 0;
+        int horizontalScroll = 0;
+    };
+
+    // how the file was last read in
+    struct LoadInfo
+    {
+        qint64 size = -1; // bytes on disk
+        QString encoding;
+        qint64 milliseconds = -1; // from opening the file until the document had all of it
+    };
+
+
     explicit editor(QTabWidget *parent, QMainWindow* mainWindow);
     ~editor();
 
+    // the question asked when a file with unsaved changes is closed, true if they want it saved
+    static bool askToSave(QWidget* dialogParent, const QString& filePath);
+    // writes text unsaved elsewhere (not in an editors document) to filePath if askToSave says so, then removes
+    // its journal. if the write fails the journal stays so the text is offered again on the next start
+    static void saveOrDiscardText(QWidget* dialogParent, const QString& filePath, const QString& text);
+
     // multiple methods that just call on the same for the main plaintTextEdit
     inline QString getText() const
     {
-        return textEdit->toPlainText();
+        return buffer.toString();
+    }
+
+    // piece table kept in sync with the document, read through this instead of copying the document out
+    inline const TextBuffer& textBuffer() const
+    {
+        return buffer;
     }
 
     inline void setText(const QString& text)
@@ -36,11 +80,10 @@ public:
     }
 
     void commentLines(); // base functionality after clicking Ctrl + /, checks what actions should be done
-    void addComments(); // adds comments to blocks of code
-    void removeComments(); // uncomments a block of comments
 
-    void saveFile();
+    void saveFile(); // writes the file on a background thread, returns right away
     void saveAs();
+    void autoSave(); // same as saveFile but skipped if the text is the same as whats on disk
 
     // true means there are changes not saved in the file (for actions like opening another)
     inline bool unsavedChanges() const
@@ -52,34 +95,97 @@ public:
     {
         return currentFile;
     }
+    inline const LoadInfo& loadInfo() const
+    {
+        return lastLoad;
+    }
 
     void openFile(QFile& file);
 
+    // puts back text recovered from an edit journal, as an undoable edit on top of whats on disk
+    void restoreText(const QString& text);
+
+    // selects length characters from column on a 0 based line and scrolls it into the middle of the view
+    void goToLine(int line, int column, int length);
+
+    ViewState viewState() const;
+    void restoreViewState(const ViewState& state); // waits for a large file to finish loading, like goToLine
+
+    // for edits made in many places inside one edit block (MultiCursor). the document reports them as one change
+    // from the first to the last, copying that span into the buffer would cost as much as the text between them,
+    // so syncBuffer skips it and each edit is recorded on its own instead, back to front, right after its made
+    void beginBatchedEdit();
+    void recordBatchedEdit(int position, int removed, int added); // added characters are read back from the document
+    void endBatchedEdit(); // after the edit block has ended
+
+    // rough bytes this editor keeps resident: the document and its layout, the piece table, the highlighting
+    qint64 memoryEstimate() const;
+
+    // the editor is being swapped for a placeholder to free its memory, the destructor wont ask to save and
+    // leaves the edit journal on disk, since the unsaved text lives on in the placeholder
+    inline void releaseForEviction()
+    {
+        evicted = true;
+    }
+
+    // true while a large file is still streaming in, the document only holds part of the file until then
+    inline bool isLoading() const
+    {
+        return loaderThread != nullptr;
+    }
+
+    // true while a save is being written in the background
+    inline bool isSaving() const
+    {
+        return saverThread != nullptr;
+    }
+
     inline void showSearchAndReplace()
     {
         this->searchAndReplace->showWidget();
     };
 
+signals:
+    void bufferChanged(); // the text changed, formatting only changes dont count
+    void loaded(); // the whole file is in the document, loadInfo has its numbers
+    void fileRenamed(const QString& newPath); // by save as
+
 protected:
     void resizeEvent(QResizeEvent*) override;
     void keyPressEvent(QKeyEvent *event) override;
 
 private:
-    void createLineNumbersOnFileOpen(int lineNumbers);
+    void loadLargeFile(); // streams the file in through a FileLoader on its own thread
+    void stopLoader();
+    void finishLoading(const QByteArray& contentHash);
+    void setLinesCommented(const QTextBlock& first, const QTextBlock& last, bool commented); // first to last inclusive
+    void startSave(bool skipIfUnchanged);
+    void finishSaving();
+    void compactBuffer(); // merges the buffers pieces on compactor, then swaps the result in with any edits since replayed
+    void replaceInBuffer(qsizetype position, qsizetype removed, const QString& inserted); // every edit to buffer after loading goes through this
+    bool saveFileNow(); // saves on the gui thread, for the destructor where theres no event loop to wait on. false if it failed
+    QString documentText(int position, int length) const; // plain text of part of the document
 
 private slots:
-    void synchronizeScrollBars(); // matches the scroll value for the text and the line numbers
-    void calculateNumberOfLines(int newBlockCount);
     void updateTabTitle(); // add the * to the tab title if it has unsaved changes
+    void appendLoadedChunk(const QString& text, qint64 bytesRead);
+    void syncBuffer(int from, int charsRemoved, int charsAdded); // mirrors a document change into the piece table
 
 private:
     inline static QFont font{"Courier"};
+    inline static constexpr QChar commentSymbol{u'#'};
+    inline static constexpr int estimatedBytesPerCharacter = 12; // a rough guess across all of the above
 
-    int previousNumberOfLines = 0;
     QString currentFile; // can be const but do want to add functionality to changing the file of an open tab
+    TextBuffer buffer; // declared before searchAndReplace, which keeps a pointer to it
 
-    // If this goes after the 2 widgets that reference it, app crashes
-    QPlainTextEdit *textEdit, *lineNumberTextEdit;
+    // members are initialized in the order theyre declared, not the order of the init list. textEdit has to come before
+    // everything built from it below (the gutter, selectionLayers, multiCursor, search and the highlighter), and
+    // selectionLayers before multiCursor and searchAndReplace which keep a pointer to it
+    QPlainTextEdit *textEdit;
+    LineNumberArea* lineNumberArea;
+    SelectionLayers selectionLayers; // search highlights and multi cursor selections share the extra selections through this
+    MultiCursor* multiCursor; // over the text edits viewport, a child of it
 
     QHBoxLayout *layout;
 
@@ -89,6 +195,39 @@ private:
 
     std::unique_ptr<SyntaxHighlighter> syntaxHighlighter;
 
+    QProgressBar* progressBar; // shown in the bottom right while a file streams in
+    QThread* loaderThread = nullptr; // only exists during a large file load
+    FileLoader* fileLoader = nullptr; // lives on loaderThread, deletes itself when the thread finishes
+    qint64 loadTotalBytes = 0;
+    QElapsedTimer loadTimer;
+    LoadInfo lastLoad;
+
+    QThread* saverThread = nullptr; // only exists while a save is being written
+    FileSaver* fileSaver = nullptr; // lives on saverThread, deletes itself when the thread finishes
+    bool saveAgain = false; // saved again while a save was running, the newer text gets written once it finishes
+    quint64 savedRevision = 0; // buffer revision last known to match the file
+    QByteArray savedContentHash; // FileSaver::contentHash of the text on disk, empty if not known
+
+    QThreadPool compactor; // one thread, merging a big buffers pieces copies the whole text so it stays off the gui thread
+    bool compactingBuffer = false;
+    struct BufferEdit
+    {
+        qsizetype position;
+        qsizetype removed;
+        QString inserted;
+    };
+    QVector<BufferEdit> editsSinceCompaction; // made while compactor works on an older snapshot
+    bool batchedEdit = false; // between beginBatchedEdit and endBatchedEdit
+    bool batchChanged = false;
+
+    EditJournal* journal = nullptr; // crash recovery log of unsaved edits, started once the file is open
+    QString pendingRestore; // recovered text waiting for a large file to finish loading
+    int pendingLine = -1; // a goToLine waiting for a large file to finish loading
+    int pendingColumn = 0;
+    int pendingLength = 0;
+    std::optional<ViewState> pendingViewState; // a restoreViewState waiting for a large file to finish loading
+    bool evicted = false;
+
 };
 
 
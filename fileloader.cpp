@@ -0,0 +1,69 @@
+#include "fileloader.h"
+#include "filesaver.h"
+
+FileLoader::FileLoader(const QString& filePath)
+    : QObject{nullptr},
+    file(filePath),
+    contentHash(FileSaver::contentHashAlgorithm)
+{
+}
+
+FileLoader::~FileLoader()
+{
+    if(mapped != nullptr){
+        file.unmap(const_cast<uchar*>(mapped));
+    }
+}
+
+void FileLoader::open()
+{
+    if(!file.open(QIODevice::ReadOnly)){
+        emit failed("Can Not Open File " + file.errorString());
+        return;
+    }
+
+    fileSize = file.size();
+    mapped = file.map(0, fileSize);
+    if(mapped == nullptr){
+        emit failed("Can Not Map File " + file.errorString());
+        return;
+    }
+
+    // same detection QTextStream does, a utf 16/32 byte order mark wins, otherwise its utf 8
+    auto encoding = QStringConverter::encodingForData(QByteArrayView(mapped, qMin<qint64>(fileSize, 4)));
+    decoder = QStringDecoder(encoding.value_or(QStringConverter::Utf8));
+
+    emit opened(fileSize, QString::fromLatin1(QStringConverter::nameForEncoding(encoding.value_or(QStringConverter::Utf8))));
+}
+
+void FileLoader::readNextChunk()
+{
+    if(mapped == nullptr){
+        return; // already finished (or never opened)
+    }
+
+    const qint64 length = qMin(chunkSize, fileSize - offset);
+    QString text = decoder.decode(QByteArrayView(mapped + offset, length));
+    offset += length;
+
+    // the old path opened the file in text mode, so line endings get the same translation here
+    if(pendingCarriageReturn){
+        text.prepend(u'\r');
+        pendingCarriageReturn = false;
+    }
+    if(offset < fileSize && text.endsWith(u'\r')){
+        text.chop(1);
+        pendingCarriageReturn = true;
+    }
+    text.replace(QStringLiteral("\r\n"), QStringLiteral("\n"));
+
+    FileSaver::addToContentHash(contentHash, text);
+    emit chunkReady(text, offset);
+
+    if(offset >= fileSize){
+        file.unmap(const_cast<uchar*>(mapped));
+        mapped = nullptr;
+        file.close();
+        emit finished(contentHash.result());
+    }
+}
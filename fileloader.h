@@ -0,0 +1,44 @@
+#ifndef FILELOADER_H
+#define FILELOADER_H
+
+#include <QObject>
+#include <QFile>
+#include <QStringDecoder>
+#include <QCryptographicHash>
+
+// reads a large file for the editor without blocking the gui thread
+// the file is memory mapped and decoded a chunk at a time on the thread this object is moved to,
+// the editor asks for the next chunk only after inserting the previous one so at most one decoded chunk waits in memory
+class FileLoader : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FileLoader(const QString& filePath);
+    ~FileLoader();
+
+    // files smaller than this are still read in one go, the thread round trip isnt worth it
+    inline static constexpr qint64 largeFileThreshold = 2 * 1024 * 1024;
+    inline static constexpr qint64 chunkSize = 1024 * 1024; // bytes decoded per chunk
+
+public slots:
+    void open(); // maps the file and emits opened, or failed if it cant be read
+    void readNextChunk(); // decodes the next chunk and emits chunkReady, or finished once the whole file is read
+
+signals:
+    void opened(qint64 totalBytes, const QString& encoding);
+    void chunkReady(const QString& text, qint64 bytesRead);
+    void finished(const QByteArray& contentHash); // FileSaver::contentHash of all the text sent, so the gui thread doesnt rehash it
+    void failed(const QString& errorMessage);
+
+private:
+    QFile file;
+    const uchar* mapped = nullptr;
+    qint64 fileSize = 0;
+    qint64 offset = 0;
+
+    QStringDecoder decoder; // stateful, so a multi byte character split between chunks still decodes
+    bool pendingCarriageReturn = false; // a \r at the end of a chunk might be the first half of a \r\n
+    QCryptographicHash contentHash; // of every chunk sent so far
+};
+
+#endif // FILELOADER_H
@@ -0,0 +1,93 @@
+#include "filesaver.h"
+#include <QSaveFile>
+#include <QStringEncoder>
+
+#if defined(Q_OS_UNIX)
+#include <unistd.h>
+#endif
+
+FileSaver::FileSaver(const QString& filePath, const TextBuffer& snapshot, const QByteArray& unchangedHash)
+    : QObject{nullptr},
+    filePath(filePath),
+    snapshot(snapshot),
+    unchangedHash(unchangedHash)
+{
+}
+
+QByteArray FileSaver::contentHash(const TextBuffer& snapshot)
+{
+    QCryptographicHash hash(contentHashAlgorithm); // only compared against itself, speed matters more than strength
+    snapshot.forEachChunk([&hash](QStringView chunk){
+        addToContentHash(hash, chunk);
+    });
+    return hash.result();
+}
+
+void FileSaver::addToContentHash(QCryptographicHash& hash, QStringView text)
+{
+    hash.addData(QByteArrayView(reinterpret_cast<const char*>(text.utf16()), text.size() * qsizetype(sizeof(char16_t))));
+}
+
+template<typename Progress>
+QString FileSaver::writeChunks(const QString& filePath, const TextBuffer& snapshot, QByteArray* hash, Progress progress)
+{
+    QSaveFile file(filePath); // writes to a temporary file, commit renames it over the target
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text)){
+        return "Unable to Save File " + file.errorString();
+    }
+
+    QStringEncoder encoder(QStringConverter::Utf8); // stateful, a surrogate pair split between chunks still encodes
+    QCryptographicHash textHash(contentHashAlgorithm);
+    qint64 written = 0;
+    bool ok = true;
+
+    snapshot.forEachChunk([&](QStringView piece){
+        for(qsizetype offset = 0; ok && offset < piece.size(); offset += chunkSize){
+            const QStringView chunk = piece.mid(offset, chunkSize);
+            addToContentHash(textHash, chunk);
+            const QByteArray bytes = encoder.encode(chunk);
+            ok = file.write(bytes) == bytes.size();
+            written += chunk.size();
+            progress(written);
+        }
+    });
+
+    if(ok) ok = file.flush();
+#if defined(Q_OS_UNIX)
+    // the data has to be on disk before the rename, otherwise a crash can leave an empty file behind
+    if(ok) ok = ::fsync(file.handle()) == 0;
+#endif
+    if(!ok){
+        const QString error = file.errorString();
+        file.cancelWriting(); // the old file stays untouched
+        return "Unable to Save File " + error;
+    }
+
+    if(!file.commit()){
+        return "Unable to Save File " + file.errorString();
+    }
+    if(hash != nullptr) *hash = textHash.result();
+    return QString();
+}
+
+QString FileSaver::write(const QString& filePath, const TextBuffer& snapshot)
+{
+    return writeChunks(filePath, snapshot, nullptr, [](qint64){});
+}
+
+void FileSaver::save()
+{
+    if(!unchangedHash.isEmpty() && contentHash(snapshot) == unchangedHash){
+        emit saved(snapshot.revision(), unchangedHash); // the same text is already on disk
+        return;
+    }
+
+    const qint64 total = snapshot.size();
+    QByteArray hash;
+    const QString error = writeChunks(filePath, snapshot, &hash, [this, total](qint64 written){
+        emit progress(written, total);
+    });
+
+    if(error.isEmpty()) emit saved(snapshot.revision(), hash);
+    else emit failed(error);
+}
@@ -0,0 +1,48 @@
+#ifndef FILESAVER_H
+#define FILESAVER_H
+
+#include <QObject>
+#include <QCryptographicHash>
+#include "textbuffer.h"
+
+// writes a snapshot of an editor's buffer to disk without blocking the gui thread
+// the text is encoded a chunk at a time into a temporary file next to the target, which is flushed to disk
+// and then renamed over the old file, so a crash halfway through a save leaves the previous version intact
+// given the hash of whats already on disk, a save of the same text is skipped without writing anything
+class FileSaver : public QObject
+{
+    Q_OBJECT
+public:
+    FileSaver(const QString& filePath, const TextBuffer& snapshot, const QByteArray& unchangedHash = QByteArray());
+
+    inline static constexpr qsizetype chunkSize = 1024 * 1024; // characters encoded per write
+
+    // the same write done on the calling thread, for when theres no event loop left to wait on (closing the app)
+    // returns an empty string on success, otherwise the error
+    static QString write(const QString& filePath, const TextBuffer& snapshot);
+
+    // hash of the text itself (not the encoded bytes), what unchangedHash gets compared against
+    static QByteArray contentHash(const TextBuffer& snapshot);
+    // the same hash fed a piece of text at a time, for text thats still on its way into a buffer
+    inline static constexpr QCryptographicHash::Algorithm contentHashAlgorithm = QCryptographicHash::Md5;
+    static void addToContentHash(QCryptographicHash& hash, QStringView text);
+
+public slots:
+    void save(); // emits saved, or failed if the file couldnt be written
+
+signals:
+    void progress(qint64 charactersWritten, qint64 totalCharacters);
+    void saved(quint64 revision, const QByteArray& contentHash); // the buffer revision that is now on disk
+    void failed(const QString& errorMessage);
+
+private:
+    template<typename Progress>
+    static QString writeChunks(const QString& filePath, const TextBuffer& snapshot, QByteArray* hash, Progress progress);
+
+private:
+    QString filePath;
+    TextBuffer snapshot; // shares the editors buffers, later edits dont touch it
+    QByteArray unchangedHash; // empty means always write
+};
+
+#endif // FILESAVER_H
@@ -0,0 +1,184 @@
+#include "findinfiles.h"
+#include "projectindexer.h"
+#include "searchkernel.h"
+#include <QByteArrayMatcher>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <cstring>
+#include <utility>
+
+struct FindInFiles::Search
+{
+    Search(const QString& text, Qt::CaseSensitivity caseSensitivity) :
+        kernel(text, caseSensitivity)
+    {
+        // ascii case folding doesnt line up byte for byte once its utf-8, only a case sensitive search can skip ahead
+        if(caseSensitivity == Qt::CaseSensitive) utf8Needle.setPattern(text.toUtf8());
+    }
+
+    quint64 generation = 0;
+    QString root;
+    SearchKernel kernel;
+    QByteArrayMatcher utf8Needle; // empty pattern means every file gets decoded and searched
+    bool wholeWords = false;
+
+    std::atomic<int> pending{0}; // pool tasks not finished yet
+    std::atomic<int> filesSearched{0};
+    std::atomic<qsizetype> matchCount{0};
+    std::atomic<bool> truncated{false};
+};
+
+FindInFiles::FindInFiles(QObject* parent) :
+    QObject(parent)
+{
+}
+
+FindInFiles::~FindInFiles()
+{
+    cancel();
+    pool.waitForDone();
+}
+
+quint64 FindInFiles::search(const QString& root, const QStringList& files, const QString& text,
+                            Qt::CaseSensitivity caseSensitivity, bool wholeWords)
+{
+    const std::shared_ptr<Search> search = std::make_shared<Search>(text, caseSensitivity);
+    search->generation = latestGeneration.fetch_add(1, std::memory_order_relaxed) + 1; // anything older stops
+    search->root = root;
+    search->wholeWords = wholeWords;
+    search->pending = 1;
+
+    pool.start([this, search, files]{ walk(search, files); });
+    return search->generation;
+}
+
+void FindInFiles::cancel()
+{
+    latestGeneration.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool FindInFiles::stopped(const Search& search) const
+{
+    return latestGeneration.load(std::memory_order_relaxed) != search.generation || search.truncated.load(std::memory_order_relaxed);
+}
+
+void FindInFiles::walk(const std::shared_ptr<Search>& search, const QStringList& files)
+{
+    QStringList batch;
+    const auto add = [this, &search, &batch](const QString& filePath){
+        batch.append(filePath);
+        if(batch.size() < batchFiles) return;
+        search->pending.fetch_add(1, std::memory_order_relaxed);
+        pool.start([this, search, paths = std::exchange(batch, QStringList())]{
+            searchBatch(search, paths);
+            finishTask(search);
+        });
+    };
+
+    if(!files.isEmpty()){
+        for(const QString& filePath : files){
+            if(stopped(*search)) break;
+            add(filePath);
+        }
+    }
+    else{
+        // same rules as the project index, no hidden entries, symlinks or the usual generated directories
+        QStringList directories{search->root};
+        while(!directories.isEmpty() && !stopped(*search)){
+            QDirIterator entries(directories.takeLast(), QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+            while(entries.hasNext()){
+                entries.next();
+                const QFileInfo info = entries.fileInfo();
+                if(!info.isDir()) add(info.filePath());
+                else if(!ProjectIndexer::skippedDirectories.contains(info.fileName())) directories.append(info.filePath());
+            }
+        }
+    }
+
+    if(!batch.isEmpty() && !stopped(*search)) searchBatch(search, batch); // counts as this task, pending isnt touched
+    finishTask(search);
+}
+
+void FindInFiles::searchBatch(const std::shared_ptr<Search>& search, const QStringList& paths)
+{
+    QList<FileMatches> results;
+    int searched = 0;
+    for(const QString& filePath : paths){
+        if(stopped(*search)) break;
+        searchFile(*search, filePath, &results);
+        ++searched;
+    }
+
+    search->filesSearched.fetch_add(searched, std::memory_order_relaxed);
+    if(!results.isEmpty() && latestGeneration.load(std::memory_order_relaxed) == search->generation){
+        emit matchesFound(search->generation, results);
+    }
+}
+
+void FindInFiles::searchFile(Search& search, const QString& filePath, QList<FileMatches>* results)
+{
+    QFile file(filePath);
+    if(!file.open(QIODevice::ReadOnly)) return;
+
+    const qint64 size = file.size();
+    if(size <= 0 || size > maxFileSize) return;
+
+    // mapped instead of read, the pages come straight from the page cache without a copy
+    QByteArray readBytes;
+    const char* bytes = reinterpret_cast<const char*>(file.map(0, size));
+    qsizetype length = qsizetype(size);
+    if(bytes == nullptr){
+        readBytes = file.readAll(); // some file systems cant be mapped
+        bytes = readBytes.constData();
+        length = readBytes.size();
+    }
+
+    if(std::memchr(bytes, '\0', size_t(qMin<qint64>(length, binaryCheckBytes))) != nullptr) return;
+    if(!search.utf8Needle.pattern().isEmpty() && search.utf8Needle.indexIn(bytes, length) < 0) return;
+
+    const QString text = QString::fromUtf8(bytes, length);
+    file.close(); // unmaps, everything from here on works on the decoded copy
+
+    FileMatches found;
+    found.filePath = filePath;
+
+    const qsizetype needleSize = search.kernel.size();
+    qsizetype line = 0;
+    qsizetype lineStart = 0;
+    qsizetype nextNewline = text.indexOf(u'\n');
+
+    for(qsizetype position = search.kernel.indexIn(text); position >= 0; ){
+        if(search.wholeWords && !SearchKernel::isWholeWord(text, position, needleSize)){
+            position = search.kernel.indexIn(text, position + 1);
+            continue;
+        }
+
+        while(nextNewline >= 0 && nextNewline < position){
+            ++line;
+            lineStart = nextNewline + 1;
+            nextNewline = text.indexOf(u'\n', lineStart);
+        }
+
+        const qsizetype lineEnd = nextNewline < 0 ? text.size() : nextNewline;
+        QString lineText = text.mid(lineStart, qMin<qsizetype>(lineEnd - lineStart, maxLineText));
+        if(lineText.endsWith(u'\r')) lineText.chop(1);
+        found.matches.append(FileMatch{int(line), int(position - lineStart), int(needleSize), lineText});
+
+        if(search.matchCount.fetch_add(1, std::memory_order_relaxed) + 1 >= maxMatches){
+            search.truncated = true; // every other task stops at its next file
+            break;
+        }
+        position = search.kernel.indexIn(text, position + qMax<qsizetype>(needleSize, 1));
+    }
+
+    if(!found.matches.isEmpty()) results->append(std::move(found));
+}
+
+void FindInFiles::finishTask(const std::shared_ptr<Search>& search)
+{
+    if(search->pending.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+
+    emit searchFinished(search->generation, search->filesSearched.load(), search->matchCount.load(), search->truncated.load());
+}
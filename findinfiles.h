@@ -0,0 +1,68 @@
+#ifndef FINDINFILES_H
+#define FINDINFILES_H
+
+#include <QObject>
+#include <QMetaType>
+#include <QThreadPool>
+#include <QStringList>
+#include <atomic>
+#include <memory>
+
+struct FileMatch
+{
+    int line; // 0 based
+    int column; // utf-16 units from the start of the line, what a QTextCursor counts in
+    int length;
+    QString lineText; // the line the match is on, cut short if its very long
+};
+
+struct FileMatches
+{
+    QString filePath;
+    QVector<FileMatch> matches;
+};
+Q_DECLARE_METATYPE(FileMatches)
+
+// literal search through every file under a folder, on a thread pool
+// files are handed out to the pool in small batches as the folder is walked, so searching starts before the walk
+// is done. each file is memory mapped, files with a NUL byte near the start are taken as binary and skipped, and a
+// case sensitive search first looks for the utf-8 bytes of the needle so files without it never get decoded. the
+// rest is decoded and searched with SearchKernel, the same simd search the editor's find uses.
+// results stream back a batch at a time, and starting a new search (or cancel) stops the old one at the next file
+class FindInFiles : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FindInFiles(QObject* parent);
+    ~FindInFiles(); // cancels, and waits for the files being searched right now
+
+    // files are absolute paths, empty means walk everything under root. returns the generation results are tagged with
+    quint64 search(const QString& root, const QStringList& files, const QString& text, Qt::CaseSensitivity caseSensitivity,
+                   bool wholeWords);
+    void cancel();
+
+signals:
+    void matchesFound(quint64 generation, const QList<FileMatches>& results);
+    void searchFinished(quint64 generation, int filesSearched, qsizetype matchCount, bool truncated);
+
+private:
+    struct Search;
+
+    void walk(const std::shared_ptr<Search>& search, const QStringList& files); // on the pool
+    void searchBatch(const std::shared_ptr<Search>& search, const QStringList& paths); // on the pool
+    void searchFile(Search& search, const QString& filePath, QList<FileMatches>* results);
+    void finishTask(const std::shared_ptr<Search>& search);
+    bool stopped(const Search& search) const;
+
+private:
+    inline static constexpr int batchFiles = 32; // files per pool task
+    inline static constexpr qint64 maxFileSize = 256 * 1024 * 1024; // bytes, anything bigger isnt source
+    inline static constexpr qint64 binaryCheckBytes = 8192; // where a NUL makes it binary, like grep
+    inline static constexpr int maxLineText = 300; // characters of the line kept for showing
+    inline static constexpr qsizetype maxMatches = 20000; // the search stops after this many
+
+    QThreadPool pool;
+    std::atomic<quint64> latestGeneration{0};
+};
+
+#endif // FINDINFILES_H
@@ -0,0 +1,184 @@
+#include "findinfilesdock.h"
+#include "projectindexer.h"
+#include <QCheckBox>
+#include <QDir>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+#include <utility>
+
+FindInFilesDock::FindInFilesDock(ProjectIndexer* indexer, QWidget* parent) :
+    QDockWidget(tr("Find in Files"), parent),
+    indexer(indexer),
+    engine(new FindInFiles(this))
+{
+    setObjectName("findInFilesDock");
+    setAllowedAreas(Qt::BottomDockWidgetArea | Qt::RightDockWidgetArea | Qt::LeftDockWidgetArea);
+
+    QWidget* contents = new QWidget(this);
+    searchLineEdit = new QLineEdit(contents);
+    searchLineEdit->setPlaceholderText(tr("Search the folder, Enter to start"));
+    searchLineEdit->setClearButtonEnabled(true);
+    isCaseSensitive = new QCheckBox(tr("Match Case"), contents);
+    isMatchWholeWord = new QCheckBox(tr("Whole Words"), contents);
+    stopButton = new QPushButton(tr("Stop"), contents);
+    stopButton->setEnabled(false);
+    statusLabel = new QLabel(contents);
+    resultsTree = new QTreeWidget(contents);
+    resultsTree->setHeaderHidden(true);
+    resultsTree->setUniformRowHeights(true); // lets the view skip measuring every row
+
+    QHBoxLayout* searchRow = new QHBoxLayout;
+    searchRow->addWidget(searchLineEdit, 1);
+    searchRow->addWidget(isCaseSensitive);
+    searchRow->addWidget(isMatchWholeWord);
+    searchRow->addWidget(stopButton);
+
+    QVBoxLayout* layout = new QVBoxLayout(contents);
+    layout->setContentsMargins(4, 4, 4, 4);
+    layout->addLayout(searchRow);
+    layout->addWidget(statusLabel);
+    layout->addWidget(resultsTree);
+    setWidget(contents);
+
+    flushTimer.setInterval(flushInterval);
+    connect(&flushTimer, &QTimer::timeout, this, &FindInFilesDock::flushResults);
+
+    // searching the whole folder on every keystroke would be a lot, it waits for Enter
+    connect(searchLineEdit, &QLineEdit::returnPressed, this, &FindInFilesDock::startSearch);
+    connect(isCaseSensitive, &QCheckBox::toggled, this, [this]{
+        if(!searchLineEdit->text().isEmpty()) startSearch();
+    });
+    connect(isMatchWholeWord, &QCheckBox::toggled, this, [this]{
+        if(!searchLineEdit->text().isEmpty()) startSearch();
+    });
+    connect(stopButton, &QPushButton::clicked, this, &FindInFilesDock::stopSearch);
+    connect(resultsTree, &QTreeWidget::itemActivated, this, &FindInFilesDock::activateItem);
+
+    connect(engine, &FindInFiles::matchesFound, this, &FindInFilesDock::onMatchesFound);
+    connect(engine, &FindInFiles::searchFinished, this, &FindInFilesDock::onSearchFinished);
+}
+
+void FindInFilesDock::setFolder(const QString& newFolder)
+{
+    if(folder == newFolder) return;
+
+    stopSearch();
+    folder = newFolder;
+    resultsTree->clear();
+    pendingResults.clear();
+    statusLabel->setText(QDir::toNativeSeparators(folder));
+}
+
+void FindInFilesDock::showAndFocus(const QString& initialText)
+{
+    if(!initialText.isEmpty()) searchLineEdit->setText(initialText);
+    show();
+    raise();
+    searchLineEdit->setFocus();
+    searchLineEdit->selectAll();
+}
+
+void FindInFilesDock::startSearch()
+{
+    const QString text = searchLineEdit->text();
+    if(text.isEmpty() || folder.isEmpty()) return;
+
+    // the index already knows every file when its the same folder, no need to walk it again
+    QStringList files;
+    const QString root = QDir(folder).absolutePath();
+    if(indexer != nullptr && indexer->isReady() && indexer->root() == root){
+        const QList<IndexedFile> indexed = indexer->files();
+        files.reserve(indexed.size());
+        for(const IndexedFile& file : indexed) files.append(root + "/" + file.path);
+    }
+
+    resultsTree->clear();
+    pendingResults.clear();
+    shownMatches = 0;
+
+    generation = engine->search(root, files, text, isCaseSensitive->isChecked() ? Qt::CaseSensitive : Qt::CaseInsensitive,
+                               isMatchWholeWord->isChecked());
+    searching = true;
+    stopButton->setEnabled(true);
+    statusLabel->setText(tr("Searching..."));
+    flushTimer.start();
+}
+
+void FindInFilesDock::stopSearch()
+{
+    if(!searching) return;
+
+    engine->cancel();
+    searching = false;
+    stopButton->setEnabled(false);
+    flushResults();
+    flushTimer.stop();
+    statusLabel->setText(tr("Stopped, %n match(es) so far", nullptr, int(shownMatches)));
+}
+
+void FindInFilesDock::onMatchesFound(quint64 resultGeneration, const QList<FileMatches>& results)
+{
+    if(resultGeneration != generation || !searching) return; // from a search thats been replaced or stopped
+    pendingResults.append(results);
+}
+
+void FindInFilesDock::onSearchFinished(quint64 resultGeneration, int filesSearched, qsizetype matchCount, bool truncated)
+{
+    if(resultGeneration != generation || !searching) return;
+
+    searching = false;
+    stopButton->setEnabled(false);
+    flushResults();
+    flushTimer.stop();
+
+    QString status = tr("%n match(es)", nullptr, int(matchCount)) + " " + tr("in %n file(s) searched", nullptr, filesSearched);
+    if(truncated) status += " " + tr("(stopped at the result limit)");
+    statusLabel->setText(status);
+}
+
+void FindInFilesDock::flushResults()
+{
+    if(pendingResults.isEmpty()) return;
+
+    const QDir root(folder);
+    QList<QTreeWidgetItem*> fileItems;
+    fileItems.reserve(pendingResults.size());
+
+    for(const FileMatches& file : std::exchange(pendingResults, QList<FileMatches>())){
+        QTreeWidgetItem* fileItem = new QTreeWidgetItem;
+        fileItem->setText(0, QString("%1 (%2)").arg(QDir::toNativeSeparators(root.relativeFilePath(file.filePath))).arg(file.matches.size()));
+        fileItem->setToolTip(0, file.filePath);
+        fileItem->setData(0, PathRole, file.filePath);
+
+        for(const FileMatch& match : file.matches){
+            QTreeWidgetItem* matchItem = new QTreeWidgetItem(fileItem);
+            matchItem->setText(0, QString("%1: %2").arg(match.line + 1).arg(match.lineText.trimmed()));
+            matchItem->setData(0, PathRole, file.filePath);
+            matchItem->setData(0, LineRole, match.line);
+            matchItem->setData(0, ColumnRole, match.column);
+            matchItem->setData(0, LengthRole, match.length);
+        }
+        shownMatches += file.matches.size();
+        fileItems.append(fileItem);
+    }
+
+    // one insert for the whole batch, the view lays out once
+    resultsTree->addTopLevelItems(fileItems);
+    for(QTreeWidgetItem* fileItem : std::as_const(fileItems)){
+        if(fileItem->childCount() <= 20) fileItem->setExpanded(true); // big ones stay folded so the rest can be seen
+    }
+
+    if(searching) statusLabel->setText(tr("Searching... %n match(es) so far", nullptr, int(shownMatches)));
+}
+
+void FindInFilesDock::activateItem(QTreeWidgetItem* item)
+{
+    if(item == nullptr || item->parent() == nullptr) return; // file rows just fold and unfold
+
+    emit resultActivated(item->data(0, PathRole).toString(), item->data(0, LineRole).toInt(), item->data(0, ColumnRole).toInt(),
+                         item->data(0, LengthRole).toInt());
+}
@@ -0,0 +1,67 @@
+#ifndef FINDINFILESDOCK_H
+#define FINDINFILESDOCK_H
+
+#include <QDockWidget>
+#include <QTimer>
+#include "findinfiles.h"
+
+class QCheckBox;
+class QLabel;
+class QLineEdit;
+class QPushButton;
+class QTreeWidget;
+class QTreeWidgetItem;
+class ProjectIndexer;
+
+// the find in files panel: a search box for the opened folder, and the results grouped by file
+// results are shown as they stream in from FindInFiles, added to the tree at most once a frame so a search with
+// thousands of hits doesnt repaint for every file. activating a result opens the file on that line
+class FindInFilesDock : public QDockWidget
+{
+    Q_OBJECT
+public:
+    FindInFilesDock(ProjectIndexer* indexer, QWidget* parent);
+
+    void setFolder(const QString& folder);
+    void showAndFocus(const QString& initialText = QString());
+
+signals:
+    void resultActivated(const QString& filePath, int line, int column, int length);
+
+private:
+    void startSearch();
+    void stopSearch();
+    void onMatchesFound(quint64 generation, const QList<FileMatches>& results);
+    void onSearchFinished(quint64 generation, int filesSearched, qsizetype matchCount, bool truncated);
+    void flushResults(); // puts the results that came in since the last frame into the tree
+    void activateItem(QTreeWidgetItem* item);
+
+private:
+    enum ItemData{
+        PathRole = Qt::UserRole,
+        LineRole,
+        ColumnRole,
+        LengthRole
+    };
+
+    inline static constexpr int flushInterval = 50; // milliseconds between adding streamed results
+
+    ProjectIndexer* indexer; // non-owning, its file list saves walking the folder when its the same one
+    FindInFiles* engine;
+    QString folder;
+    quint64 generation = 0; // of the search whose results are showing
+    bool searching = false;
+    qsizetype shownMatches = 0;
+
+    QList<FileMatches> pendingResults;
+    QTimer flushTimer;
+
+    QLineEdit* searchLineEdit;
+    QCheckBox* isCaseSensitive;
+    QCheckBox* isMatchWholeWord;
+    QPushButton* stopButton;
+    QLabel* statusLabel;
+    QTreeWidget* resultsTree;
+};
+
+#endif // FINDINFILESDOCK_H
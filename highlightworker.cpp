@@ -0,0 +1,25 @@
+#include "highlightworker.h"
+
+void HighlightWorker::tokenize(int requestSlot, const TextBuffer& snapshot, qsizetype position, qsizetype length, int startState)
+{
+    const QString text = snapshot.mid(position, length);
+    const QStringView view(text);
+
+    QVector<HighlightedBlock> blocks;
+    int state = startState;
+    qsizetype lineStart = 0;
+    while(true){
+        qsizetype lineEnd = view.indexOf(u'\n', lineStart);
+        if(lineEnd == -1) lineEnd = view.size();
+
+        HighlightedBlock block;
+        state = PythonLexer::tokenizeLine(view.mid(lineStart, lineEnd - lineStart), state, block.runs);
+        block.endState = state;
+        blocks.append(std::move(block));
+
+        if(lineEnd == view.size()) break;
+        lineStart = lineEnd + 1;
+    }
+
+    emit tokenized(requestSlot, blocks);
+}
@@ -0,0 +1,29 @@
+#ifndef HIGHLIGHTWORKER_H
+#define HIGHLIGHTWORKER_H
+
+#include <QObject>
+#include <QMetaType>
+#include "pythonlexer.h"
+#include "textbuffer.h"
+
+// the lexer output for one block, handed back to the gui thread to be turned into formats
+struct HighlightedBlock
+{
+    QVector<TokenRun> runs;
+    int endState = -1;
+};
+Q_DECLARE_METATYPE(HighlightedBlock)
+
+// runs PythonLexer over a range of lines from a document snapshot, lives on the highlighters worker thread
+class HighlightWorker : public QObject
+{
+    Q_OBJECT
+public:
+    // tokenizes the lines in [position, position + length) of the snapshot, the first one entering in startState
+    void tokenize(int requestSlot, const TextBuffer& snapshot, qsizetype position, qsizetype length, int startState);
+
+signals:
+    void tokenized(int requestSlot, const QVector<HighlightedBlock>& blocks);
+};
+
+#endif // HIGHLIGHTWORKER_H
@@ -0,0 +1,81 @@
+#include "interpreterpool.h"
+#include "processreaper.h"
+#include "util.h"
+#include <QTimer>
+
+InterpreterPool::InterpreterPool(QObject* parent) :
+    QObject(parent)
+{
+}
+
+InterpreterPool::~InterpreterPool()
+{
+    for(QProcess* interpreter : std::as_const(idle)) ProcessReaper::instance()->adopt(interpreter);
+}
+
+void InterpreterPool::warmUp()
+{
+    failures = 0;
+    scheduleRefill();
+}
+
+QProcess* InterpreterPool::take()
+{
+    warmUp(); // whatever happens next, the taken one gets replaced
+
+    for(qsizetype i = 0; i < idle.size(); ++i){
+        QProcess* interpreter = idle.at(i);
+        if(interpreter->state() != QProcess::Running) continue; // still starting, a cold start is just as quick
+
+        idle.removeAt(i);
+        interpreter->disconnect(this);
+        interpreter->setParent(nullptr);
+        return interpreter;
+    }
+    return nullptr;
+}
+
+QStringList InterpreterPool::coldArguments(const QString& filePath)
+{
+    return {"-u", filePath}; // -u since its a pipe, not a terminal, and output should show up as its printed
+}
+
+void InterpreterPool::scheduleRefill()
+{
+    if(refillScheduled) return;
+    refillScheduled = true;
+    QTimer::singleShot(0, this, &InterpreterPool::refill); // after the run thats being started, not before it
+}
+
+void InterpreterPool::refill()
+{
+    refillScheduled = false;
+
+    while(idle.size() < poolSize && failures < maxFailures){
+        QProcess* interpreter = new QProcess(this);
+        interpreter->setProcessChannelMode(QProcess::MergedChannels); // has to be set before its started
+        idle.append(interpreter);
+
+        connect(interpreter, &QProcess::started, this, [this]{ failures = 0; });
+        connect(interpreter, &QProcess::errorOccurred, this, [this, interpreter](QProcess::ProcessError error){
+            if(error != QProcess::FailedToStart) return;
+            ++failures; // no python, the run itself reports that when it starts cold
+            drop(interpreter);
+        });
+        connect(interpreter, &QProcess::finished, this, [this, interpreter]{
+            // it shouldnt exit before being handed a file, if it does something is off with the interpreter
+            ++failures;
+            drop(interpreter);
+            scheduleRefill();
+        });
+
+        interpreter->start(util::getPythonRunCommand(), {"-u", "-c", bootstrap});
+    }
+}
+
+void InterpreterPool::drop(QProcess* interpreter)
+{
+    idle.removeOne(interpreter);
+    interpreter->disconnect(this);
+    interpreter->deleteLater();
+}
@@ -0,0 +1,50 @@
+#ifndef INTERPRETERPOOL_H
+#define INTERPRETERPOOL_H
+
+#include <QObject>
+#include <QProcess>
+#include <QList>
+
+// keeps a couple of python interpreters started ahead of time, so a run doesnt pay for the interpreter
+// starting up and importing its standard modules. each one sits in a tiny bootstrap script that reads the path
+// of the file to run from stdin and then runs it as __main__ from its own directory. an interpreter is only
+// ever used for one run, so nothing carries over between runs, and the pool tops itself back up after each take
+class InterpreterPool : public QObject
+{
+public:
+    explicit InterpreterPool(QObject* parent);
+    ~InterpreterPool(); // the idle ones go to the ProcessReaper, closing stdin makes them exit on their own
+
+    void warmUp(); // starts filling the pool, nothing is started until the first run or this
+    QProcess* take(); // a started interpreter, nullptr if none is ready yet. the caller owns it
+
+    // how to run a file in a interpreter that isnt from the pool
+    static QStringList coldArguments(const QString& filePath);
+
+private:
+    void refill();
+    void scheduleRefill();
+    void drop(QProcess* interpreter);
+
+private:
+    inline static constexpr int poolSize = 2;
+    inline static constexpr int maxFailures = 3; // in a row, then it waits for the next take to try again
+
+    // reads one line, the path, and the rest of stdin is left for the script
+    inline static const QString bootstrap{
+        "import os, runpy, sys\n"
+        "path = sys.stdin.readline().rstrip('\\r\\n')\n"
+        "if path:\n"
+        "    directory = os.path.dirname(os.path.abspath(path))\n"
+        "    os.chdir(directory)\n"
+        "    sys.argv = [path]\n"
+        "    sys.path[0] = directory\n"
+        "    runpy.run_path(path, run_name='__main__')\n"
+    };
+
+    QList<QProcess*> idle; // started or still starting
+    int failures = 0;
+    bool refillScheduled = false;
+};
+
+#endif // INTERPRETERPOOL_H
@@ -0,0 +1,50 @@
+#include "journalwriter.h"
+#include "editjournal.h"
+#include "filesaver.h"
+#include <QSaveFile>
+#include <QDir>
+#include <QFileInfo>
+
+void JournalWriter::restart(const QString& journalPath, const QString& filePath, const TextBuffer& base)
+{
+    rewrite(journalPath, EditJournal::header(filePath, FileSaver::contentHash(base)));
+}
+
+void JournalWriter::compact(const QString& journalPath, const QString& filePath, const TextBuffer& current)
+{
+    QByteArray contents = EditJournal::header(filePath, QByteArray());
+    QDataStream out(&contents, QIODevice::Append);
+    out.setVersion(EditJournal::streamVersion);
+    out << quint8(EditJournal::SnapshotRecord) << current.toString();
+
+    rewrite(journalPath, contents);
+}
+
+void JournalWriter::append(const QByteArray& records)
+{
+    if(!file.isOpen()) return; // the header couldnt be written, records without one cant be replayed anyway
+
+    file.write(records);
+    file.flush(); // into the os, which is what survives the process dying
+}
+
+void JournalWriter::remove(const QString& journalPath)
+{
+    file.close();
+    QFile::remove(journalPath);
+}
+
+void JournalWriter::rewrite(const QString& journalPath, const QByteArray& contents)
+{
+    file.close();
+    QDir().mkpath(QFileInfo(journalPath).path());
+
+    // a crash in the middle of this leaves the previous journal rather than half of the new one
+    QSaveFile replacement(journalPath);
+    if(!replacement.open(QIODevice::WriteOnly)) return;
+    replacement.write(contents);
+    if(!replacement.commit()) return;
+
+    file.setFileName(journalPath);
+    file.open(QIODevice::WriteOnly | QIODevice::Append);
+}
@@ -0,0 +1,29 @@
+#ifndef JOURNALWRITER_H
+#define JOURNALWRITER_H
+
+#include <QObject>
+#include <QFile>
+#include "textbuffer.h"
+
+// does the file work for an EditJournal on the journals worker thread, calls arrive in order through queued invokes
+class JournalWriter : public QObject
+{
+public:
+    JournalWriter() = default;
+
+    // starts the journal over with just a header, base is the text thats on disk (hashed here, off the gui thread)
+    void restart(const QString& journalPath, const QString& filePath, const TextBuffer& base);
+    // starts the journal over with a header and a snapshot of current, the file on disk no longer matters for replay
+    void compact(const QString& journalPath, const QString& filePath, const TextBuffer& current);
+    void append(const QByteArray& records);
+    void remove(const QString& journalPath);
+
+private:
+    // writes the new contents to a temporary file and renames it over the journal, then reopens it for appending
+    void rewrite(const QString& journalPath, const QByteArray& contents);
+
+private:
+    QFile file;
+};
+
+#endif // JOURNALWRITER_H
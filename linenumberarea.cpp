@@ -0,0 +1,71 @@
+#include "linenumberarea.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QTextBlock>
+
+LineNumberArea::LineNumberArea(QPlainTextEdit* textEdit, QWidget* parent)
+    : QWidget{parent},
+    textEdit(textEdit)
+{
+    setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Expanding);
+    setFocusPolicy(Qt::NoFocus);
+    setContextMenuPolicy(Qt::NoContextMenu);
+    setCursor(Qt::ArrowCursor); // stops cursor from changing when hovering over line number
+
+    // repaints on scroll, typing and resizes of the text edit, updateRequest covers all of them
+    connect(textEdit, &QPlainTextEdit::updateRequest, this, [this]{
+        update();
+    });
+    connect(textEdit, &QPlainTextEdit::blockCountChanged, this, &LineNumberArea::updateWidth);
+
+    updateWidth(textEdit->blockCount());
+}
+
+void LineNumberArea::updateWidth(int blockCount)
+{
+    int newDigits = 2; // room for 2 digits at least so the gutter doesnt jump around on small files
+    for(int max = 100; blockCount >= max && newDigits < 10; max *= 10){
+        newDigits++;
+    }
+    if(newDigits == digits) return;
+
+    digits = newDigits;
+    const int padding = 8;
+    setFixedWidth(padding + fontMetrics().horizontalAdvance(QLatin1Char('9')) * digits);
+}
+
+void LineNumberArea::changeEvent(QEvent* event)
+{
+    QWidget::changeEvent(event);
+    if(event->type() == QEvent::FontChange){
+        digits = 0; // forces the width to be measured again with the new font
+        updateWidth(textEdit->blockCount());
+    }
+}
+
+void LineNumberArea::paintEvent(QPaintEvent* event)
+{
+    QPainter painter(this);
+    painter.fillRect(event->rect(), Qt::black);
+    painter.setPen(Qt::lightGray);
+
+    // block positions come back in viewport coordinates, the viewport sits inside the text edits frame
+    const int offsetY = textEdit->viewport()->mapTo(window(), QPoint(0, 0)).y() - mapTo(window(), QPoint(0, 0)).y();
+    const int rightPadding = 4;
+
+    // only walks the blocks on screen, starting from whatever block is at the top of the viewport
+    QTextBlock block = textEdit->cursorForPosition(QPoint(0, 0)).block();
+    while(block.isValid()){
+        if(block.isVisible()){
+            const QRect lineRect = textEdit->cursorRect(QTextCursor(block));
+            const int top = lineRect.top() + offsetY;
+            if(top > event->rect().bottom()) break;
+
+            if(top + lineRect.height() >= event->rect().top()){
+                painter.drawText(0, top, width() - rightPadding, lineRect.height(), Qt::AlignRight | Qt::AlignVCenter,
+                                 QString::number(block.blockNumber() + 1));
+            }
+        }
+        block = block.next();
+    }
+}
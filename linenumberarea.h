@@ -0,0 +1,26 @@
+#ifndef LINENUMBERAREA_H
+#define LINENUMBERAREA_H
+
+#include <QWidget>
+#include <QPlainTextEdit>
+
+// the gutter next to the text, it paints the numbers of whatever blocks are on screen straight from the
+// text edits layout, so it costs the same for a 10 line file and a million line one
+class LineNumberArea : public QWidget
+{
+public:
+    explicit LineNumberArea(QPlainTextEdit* textEdit, QWidget* parent);
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void changeEvent(QEvent* event) override;
+
+private:
+    void updateWidth(int blockCount); // grows the gutter when the line count gains a digit
+
+private:
+    QPlainTextEdit* textEdit; // non-owning
+    int digits = 0;
+};
+
+#endif // LINENUMBERAREA_H
@@ -20,5 +20,7 @@ int main(int argc, char *argv[])
     }
     MainWindow w;
     w.show();
+    w.recoverUnsavedWork();
+    w.restoreSession(); // after recovery, an editor opened here would start its journal over the one being recovered
     return a.exec();
 }
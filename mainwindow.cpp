@@ -2,16 +2,30 @@
 #include "ui_mainwindow.h"
 #include "util.h"
 #include "editor.h"
+#include "editjournal.h"
+#include "filesaver.h"
+#include "tabplaceholder.h"
 #include <QAnyStringView>
+#include <QActionGroup>
+#include <QInputDialog>
+#include <QSignalBlocker>
 
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent),
     ui(new Ui::MainWindow),
-    process (new QProcess(this)),
-    fileModel(new QFileSystemModel(this))
+    fileModel(new QFileSystemModel(this)),
+    autoSaver(new AutoSaver(this)),
+    projectIndexer(new ProjectIndexer(this)),
+    openFiles(new OpenFileRegistry(this))
 {
     ui->setupUi(this);
+    runManager = new RunManager(this->ui->terminalTabWidget, this); // after setupUi, it adds its tabs next to the terminal
+
+    findInFiles = new FindInFilesDock(projectIndexer, this);
+    addDockWidget(Qt::BottomDockWidgetArea, findInFiles);
+    findInFiles->hide();
+    quickOpen = new QuickOpen(projectIndexer, this);
 
     this->ui->actionSave->setEnabled(false);
     this->setCentralWidget(ui->stackedWidget);
@@ -30,20 +44,15 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
-    if (process->isOpen()) {
-        process->write("exit\n");
-        process->waitForFinished();
-    }
-
     // deleteAllTabs();
 
-    delete process;
-    delete ui;
+    delete ui; // the terminal hangs up on its shell as its destroyed
 }
 
 void MainWindow::closeEvent(QCloseEvent *event)
 {
 
+    saveSession(); // before the tabs are gone
     deleteAllTabs();
     QMainWindow::closeEvent(event);
 }
@@ -53,12 +62,17 @@ void MainWindow::openFileAction()
 {
     // asks to save if they have any changes on current file they are working on before opening dialog
     if(openEditor != nullptr && openEditor->unsavedChanges()){
-        QMessageBox::StandardButton saveFileQuestion = QMessageBox::question(this, tr("Save Changes?"),
-                                                                             tr("Would you like To Save Changes Before Opening a New Folder?"),
-                                                                             QMessageBox::Save | QMessageBox::Discard, QMessageBox::Save);
+        if(autoSaver->mode() == autoSaveType::SaveOnOpenNewFile){
+            openEditor->autoSave(); // the setting already answers the question
+        }
+        else{
+            QMessageBox::StandardButton saveFileQuestion = QMessageBox::question(this, tr("Save Changes?"),
+                                                                                 tr("Would you like To Save Changes Before Opening a New Folder?"),
+                                                                                 QMessageBox::Save | QMessageBox::Discard, QMessageBox::Save);
 
-        if(saveFileQuestion == QMessageBox::Save){
-            openEditor->saveFile();
+            if(saveFileQuestion == QMessageBox::Save){
+                openEditor->saveFile();
+            }
         }
     }
 
@@ -68,6 +82,59 @@ void MainWindow::openFileAction()
     if(openFile(fileName)) getAllFilesInDirectory();
 }
 
+void MainWindow::recoverUnsavedWork()
+{
+    const QList<EditJournal::Recovery> recoveries = EditJournal::recoverAll();
+    if(recoveries.isEmpty()) return;
+
+    QStringList fileNames;
+    for(const EditJournal::Recovery& recovery : recoveries) fileNames.append(recovery.filePath);
+
+    QMessageBox::StandardButton recoverQuestion = QMessageBox::question(this, tr("Recover Unsaved Changes?"),
+                                                                        tr("The editor did not close properly, these files had unsaved changes:\n\n")
+                                                                            + fileNames.join('\n')
+                                                                            + tr("\n\nWould you like to restore them?"),
+                                                                        QMessageBox::Yes | QMessageBox::No, QMessageBox::Yes);
+
+    bool openedAny = false;
+    for(const EditJournal::Recovery& recovery : recoveries){
+        if(recoverQuestion != QMessageBox::Yes){
+            QFile::remove(recovery.journalPath); // only dropped when the user says so
+        }
+        else if(openFile(recovery.filePath)){
+            openEditor->restoreText(recovery.text); // the new editor has already started its own journal in the same place
+            openedAny = true;
+        }
+        else if(saveRecoveredText(recovery.filePath, recovery.journalPath, recovery.text)){
+            openedAny = true;
+        }
+        // otherwise the journal stays put and gets offered again on the next start
+    }
+    if(openedAny) getAllFilesInDirectory();
+}
+
+bool MainWindow::saveRecoveredText(const QString& filePath, const QString& journalPath, const QString& text)
+{
+    // moved or deleted since the crash, the journal is the only copy of the text left
+    QMessageBox::StandardButton saveQuestion = QMessageBox::question(this, tr("Recover Unsaved Changes?"),
+                                                                     filePath + tr(" could not be opened. Would you like to save its recovered text somewhere else?")
+                                                                         + tr("\n\nIf not it is kept and offered again next time."),
+                                                                     QMessageBox::Save | QMessageBox::Ignore, QMessageBox::Save);
+    if(saveQuestion != QMessageBox::Save) return false;
+
+    const QString fileName = QFileDialog::getSaveFileName(this, tr("Save Recovered Text"), filePath);
+    if(fileName.isEmpty()) return false; // cancelled, still kept
+
+    const QString errorMessage = FileSaver::write(fileName, TextBuffer(text));
+    if(!errorMessage.isEmpty()){
+        QMessageBox::warning(this, tr("Warning"), errorMessage);
+        return false;
+    }
+
+    QFile::remove(journalPath); // its on disk now
+    return openFile(fileName);
+}
+
 void MainWindow::updateStatusBarCursorPosition()
 {
 
@@ -87,52 +154,11 @@ void MainWindow::initTerminalBox(const QString& path)
     this->ui->terminalBox->clear(); // clears the text in case they are switching files
     // maybe remove, or leave to a setting if they want to
 
-    process->start(util::getShellCommand());
-
-    if (!process->waitForStarted()) {
-        QMessageBox::critical(this, tr("Error"), tr("Failed to start the command process"));
-        return;
-    }
-
-    // there is no open editor if you open a folder
-    process->setWorkingDirectory(path);
-        // process->setWorkingDirectory(QFileInfo(openEditor->fileName()).absolutePath());
-
-    connect(process, &QProcess::readyReadStandardOutput, this, &MainWindow::on_StdoutAvailable);
-    connect(process, &QProcess::readyReadStandardError, this, &MainWindow::on_StderrAvailable); // Connect the error output signal
-
-}
-
-
-void MainWindow::on_StdoutAvailable()
-{ // when it is ready to be read, it reads the output and prints it to the terminal box
-    if(!process->isOpen()){
-        return;
-    }
-    QByteArray terminalOutput = process->readAllStandardOutput();
-    ui->terminalBox->appendPlainText(terminalOutput);
-}
-
-void MainWindow::on_StderrAvailable(){
-
-    if(!process->isOpen()){
+    // there is no open editor if you open a folder, so it starts in whatever directory was opened
+    if(!this->ui->terminalBox->start(util::getShellCommand(), path)){
+        QMessageBox::critical(this, tr("Error"), tr("Failed to start the command process: ") + this->ui->terminalBox->errorString());
         return;
     }
-    QByteArray terminalOutput = process->readAllStandardError();
-    // outputs the error to the terminal in red
-    ui->terminalBox->appendHtml("<span style = 'color: red;'>" + terminalOutput + "</span>");
-}
-
-
-void MainWindow::writeToTerminal()
-{
-    if (process->isOpen()){
-        QByteArray inputByteArray(ui->inputTerminalCommand->text().toUtf8() + "\n") ;
-        char *userText = inputByteArray.data();
-
-        process->write(userText); // inputs the user command into the terminal
-    }
-    ui->inputTerminalCommand->clear(); // clears the input field for the user
 }
 
 void MainWindow::setUIChanges()
@@ -146,14 +172,11 @@ void MainWindow::setUIChanges()
 
 void MainWindow::runButton()
 {
-    if(process->isOpen()){
-        showTerminal();
-        QString runPythonCommand = QString("%1 -u \"%2\"").arg(util::getPythonRunCommand(), openEditor->fileName());
-        QByteArray runFileCommand(runPythonCommand.toUtf8() + "\n") ;
+    if(openEditor == nullptr) return;
 
-        process->write(runFileCommand.data()); // inputs the user command into the terminal
-        process->waitForBytesWritten();
-    }
+    // its own process and its own tab, so it doesnt tie up the shell or mix its output with it
+    showTerminal();
+    runManager->run(openEditor->fileName());
 }
 
 void MainWindow::getAllFilesInDirectory()
@@ -201,9 +224,8 @@ bool MainWindow::openFile(const QString &filePath)
         return false;
     }
 
-    // despite the editor being the direct child of the tab, putting the flag to seach children only (not recursivly) always results in a nullptr
-    const editor* child = this->ui->openEditorsTabWidget->findChild<editor*>(filePath);
-    if(child != nullptr){
+    // by canonical path, so the same file through a symlink or a relative path still finds its tab
+    if(openFiles->tab(filePath) != nullptr){
         return false; // that means it already has a tab open on this file
     }
 
@@ -224,7 +246,7 @@ bool MainWindow::openFile(const QString &filePath)
     currentDirectory.setPath(fileDirectory.path());
 
     editor* nextPage = new editor(this->ui->openEditorsTabWidget, this);
-    nextPage->setObjectName(filePath);
+    openFiles->add(filePath, nextPage); // before the file is read, it reports the load to the registry
     openEditor = nextPage;
 
 
@@ -232,8 +254,7 @@ bool MainWindow::openFile(const QString &filePath)
     this->ui->openEditorsTabWidget->setCurrentIndex(newTab);
     // IM KEEPING THIS COMMENT JUST TO REMIND MYSELF, CHANGE OBJECT NAMES FOR UI, IT WASNT CHANGING TAB CAUSE YOU WERE CALLING IT ON THE TERMINAL TAB WIDGET
 
-    nextPage->openFile(file);
-
+    loadIntoEditor(nextPage, file);
     file.close();
 
     this->ui->fileTreeDockWidget->showNormal();
@@ -243,13 +264,152 @@ bool MainWindow::openFile(const QString &filePath)
     return true;
 }
 
-void MainWindow::updateTerminalAndOutput(const QString& path)
+void MainWindow::loadIntoEditor(editor* page, QFile& file)
+{
+    page->openFile(file);
+    autoSaver->watch(page); // after opening, so loading the text doesnt count as an edit
+    if(QFileInfo(file).suffix() == "py") runManager->warmUp(); // likely to be run, the first run shouldnt wait on python starting
+}
+
+editor* MainWindow::materializeTab(int index)
+{
+    QTabWidget* tabs = this->ui->openEditorsTabWidget;
+    TabPlaceholder* placeholder = qobject_cast<TabPlaceholder*>(tabs->widget(index));
+    if(placeholder == nullptr) return qobject_cast<editor*>(tabs->widget(index));
+
+    QFile file(placeholder->fileName());
+    if(!file.open(QIODevice::ReadOnly | QFile::Text)){
+        placeholder->showOpenError(file.errorString()); // stays a placeholder, closing the tab is up to them
+        return nullptr;
+    }
+
+    editor* page = new editor(tabs, this);
+    openFiles->replaceTab(placeholder, page);
+    {
+        // currentChanged would go off for whichever tab is current in between the insert and the remove
+        const QSignalBlocker blocker(tabs);
+        const bool wasCurrent = tabs->currentIndex() == index;
+        tabs->insertTab(index, page, tabs->tabText(index));
+        tabs->removeTab(index + 1);
+        if(wasCurrent) tabs->setCurrentIndex(index);
+    }
+    placeholder->deleteLater();
+
+    loadIntoEditor(page, file);
+    if(placeholder->hasUnsavedText()) page->restoreText(placeholder->unsavedText()); // it was evicted with edits
+    if(placeholder->viewState().has_value()) page->restoreViewState(*placeholder->viewState());
+    return page;
+}
+
+void MainWindow::currentTabChanged(int index)
+{
+    autoSaver->editorLeft(previousEditor);
+    if(index >= 0) materializeTab(index); // the first time a restored tab is shown its file gets read
+    openEditor = qobject_cast<editor*>(ui->openEditorsTabWidget->currentWidget());
+    previousEditor = openEditor;
+
+    if(openEditor != nullptr){
+        recentEditors.removeAll(openEditor);
+        recentEditors.prepend(openEditor);
+    }
+    evictInactiveTabs();
+}
+
+void MainWindow::evictInactiveTabs()
+{
+    recentEditors.removeAll(nullptr); // closed since
+
+    const qint64 budget = qint64(settings.tabMemoryBudget()) * 1024 * 1024;
+    qint64 total = 0;
+    for(const QPointer<editor>& page : std::as_const(recentEditors)) total += page->memoryEstimate();
+
+    for(qsizetype i = recentEditors.size() - 1; i >= 0 && total > budget; --i){
+        editor* page = recentEditors.at(i);
+        if(page == openEditor || page->isLoading() || page->isSaving()) continue; // the current one always stays loaded
+        if(this->ui->openEditorsTabWidget->indexOf(page) < 0) continue; // closed, waiting on its deleteLater
+
+        total -= page->memoryEstimate();
+        evictTab(page);
+        recentEditors.removeAt(i);
+    }
+}
+
+void MainWindow::evictTab(editor* page)
+{
+    QTabWidget* tabs = this->ui->openEditorsTabWidget;
+    const int index = tabs->indexOf(page);
+
+    TabPlaceholder* placeholder = new TabPlaceholder(page->fileName(), tabs);
+    if(page->unsavedChanges()) placeholder->setEvictedState(page->viewState(), page->getText());
+    else placeholder->setEvictedState(page->viewState()); // reread from disk when its shown again
+
+    openFiles->replaceTab(page, placeholder);
+    {
+        // the current tab stays the same widget, nothing needs to hear about the indexes shifting
+        const QSignalBlocker blocker(tabs);
+        tabs->insertTab(index, placeholder, tabs->tabText(index));
+        tabs->removeTab(index + 1);
+    }
+    page->releaseForEviction();
+    page->deleteLater();
+}
+
+void MainWindow::saveSession()
 {
-    if(process->state() == QProcess::Running){
+    QTabWidget* tabs = this->ui->openEditorsTabWidget;
+    QStringList files;
+    for(int i = 0; i < tabs->count(); ++i){
+        if(const editor* page = qobject_cast<editor*>(tabs->widget(i))) files.append(page->fileName());
+        else if(const TabPlaceholder* placeholder = qobject_cast<TabPlaceholder*>(tabs->widget(i))) files.append(placeholder->fileName());
+    }
+
+    QString currentFile;
+    if(openEditor != nullptr) currentFile = openEditor->fileName();
+    else if(const TabPlaceholder* placeholder = qobject_cast<TabPlaceholder*>(tabs->currentWidget())) currentFile = placeholder->fileName();
 
-        process->setWorkingDirectory(path);
+    settings.setSession(files, currentFile, projectIndexer->root());
+}
+
+void MainWindow::restoreSession()
+{
+    const QString folder = settings.sessionFolder();
+    if(!folder.isEmpty() && QFileInfo(folder).isDir()) openFolder(folder);
+
+    QTabWidget* tabs = this->ui->openEditorsTabWidget;
+    int restored = 0;
+    {
+        // nothing is read while the tabs go in, otherwise the first one added would load as it becomes current
+        const QSignalBlocker blocker(tabs);
+        for(const QString& filePath : settings.sessionFiles()){
+            if(!QFileInfo(filePath).isFile() || openFiles->tab(filePath) != nullptr) continue; // gone, or already opened by a recovery
+            TabPlaceholder* placeholder = new TabPlaceholder(filePath, tabs);
+            openFiles->add(filePath, placeholder);
+            tabs->addTab(placeholder, filePath);
+            ++restored;
+        }
     }
-    else if(process->state() == QProcess::NotRunning){
+    if(restored == 0) return;
+
+    this->ui->actionSave->setEnabled(true);
+    this->ui->stackedWidget->setCurrentIndex(1);
+    this->ui->fileTreeDockWidget->showNormal();
+    this->ui->terminalDockWidget->showNormal();
+
+    const QWidget* current = openFiles->tab(settings.sessionCurrentFile());
+    const int index = current != nullptr ? tabs->indexOf(current) : tabs->currentIndex();
+    if(index == tabs->currentIndex()) currentTabChanged(index); // already current, currentChanged wont go off for it
+    else tabs->setCurrentIndex(index);
+
+    if(openEditor == nullptr || !projectIndexer->root().isEmpty()) return;
+    currentDirectory.setPath(QFileInfo(openEditor->fileName()).path());
+    getAllFilesInDirectory();
+    updateTerminalAndOutput(currentDirectory.absolutePath());
+}
+
+void MainWindow::updateTerminalAndOutput(const QString& path)
+{
+    // a running shell stays where the user left it
+    if(!this->ui->terminalBox->isRunning()){
         // if the process isnt running, initialize it
         initTerminalBox(path);
     }
@@ -259,11 +419,15 @@ void MainWindow::openFolderDialog()
 {
     // if they try to open folder while working on something that is not saved, it asks to save beforehand
     if(openEditor != nullptr && openEditor->unsavedChanges()){
-        QMessageBox::StandardButton saveFileQuestion = QMessageBox::question(this, tr("Save Changes?"), tr("Would you like To Save Changes Before Opening a New Folder?")
-                                                                             , QMessageBox::Save | QMessageBox::Discard, QMessageBox::Save);
+        if(autoSaver->mode() == autoSaveType::SaveOnOpenNewFile){
+            openEditor->autoSave();
+        }
+        else{
+            QMessageBox::StandardButton saveFileQuestion = QMessageBox::question(this, tr("Save Changes?"), tr("Would you like To Save Changes Before Opening a New Folder?")
+                                                                                 , QMessageBox::Save | QMessageBox::Discard, QMessageBox::Save);
 
-        // TODO: add save options, if either never save or always open file in same tab call save instead
-        if(saveFileQuestion == QMessageBox::Save) openEditor->saveFile();
+            if(saveFileQuestion == QMessageBox::Save) openEditor->saveFile();
+        }
     }
 
 
@@ -277,16 +441,21 @@ void MainWindow::openFolderDialog()
         return;
     }
 
-    currentDirectory.setPath(dir);
-
     // if you open a folder, there are no more open tabs, need to clear
     deleteAllTabs();
+    openFolder(dir);
+}
+
+void MainWindow::openFolder(const QString& dir)
+{
+    currentDirectory.setPath(dir);
 
     this->ui->stackedWidget->setCurrentIndex(1); // sets the page to the text editor page
     this->ui->fileTreeDockWidget->showNormal();
     updateTerminalAndOutput(dir);
 
     getAllFilesInDirectory(dir);
+    projectIndexer->open(dir); // crawls in the background, the tree view doesnt wait on it
 }
 
 void MainWindow::openFileWhileEditing(const QString& path){
@@ -490,6 +659,10 @@ void MainWindow::connectSignals(){ // relying on the connection of slots that th
 
     // MENU ACTION BAR BUTTONS
     connect(this->ui->actionShow_Terminal, &QAction::triggered, this, &MainWindow::showTerminal);
+    connect(this->ui->actionFind_In_Files, &QAction::triggered, this, &MainWindow::showFindInFiles);
+    connect(findInFiles, &FindInFilesDock::resultActivated, this, &MainWindow::openSearchResult);
+    connect(this->ui->actionQuick_Open, &QAction::triggered, this, &MainWindow::showQuickOpen);
+    connect(quickOpen, &QuickOpen::fileChosen, this, &MainWindow::showFile);
     connect(this->ui->actionNew_Text_File, &QAction::triggered, this, &MainWindow::newTextFile);
     connect(this->ui->actionNew, &QAction::triggered, this, &MainWindow::newPythonFile);
 
@@ -555,14 +728,15 @@ void MainWindow::connectSignals(){ // relying on the connection of slots that th
         openEditor->showSearchAndReplace();
     });
 
+    setupAutoSaveMenu();
+    setupTerminalMenu();
+    setupMemoryMenu();
+
     // END OF MENU BAR ACTIONS
 
     connect(this->ui->runFileButton, &QPushButton::pressed, this, &MainWindow::runButton);
-    connect(this->ui->inputTerminalCommand, &QLineEdit::returnPressed, this, &MainWindow::writeToTerminal);
 
-    connect(this->ui->openEditorsTabWidget, &QTabWidget::currentChanged, this, [this]{
-        openEditor = qobject_cast<editor*>(ui->openEditorsTabWidget->currentWidget());
-    });
+    connect(this->ui->openEditorsTabWidget, &QTabWidget::currentChanged, this, &MainWindow::currentTabChanged);
 
     connect(this->ui->openEditorsTabWidget, &QTabWidget::tabCloseRequested, this, [this](int index){
         //delete openEditor; // call on its destructor which manages choices regarding save
@@ -571,8 +745,12 @@ void MainWindow::connectSignals(){ // relying on the connection of slots that th
         // for some reason, removing the tab through the intended method does not manage its memory, but also does deletes the tab to its right if you try to manage the memory
 
         // to negate the issue mentioned above, it sets the pointer to the intended tab to be closed, and deletes that
-        openEditor = qobject_cast<editor*>(this->ui->openEditorsTabWidget->widget(index));
-        openEditor->deleteLater();
+        // QWidget, it can be a restored or evicted tab thats still a placeholder, one with unsaved text asks to save
+        // like an editor would
+        if(TabPlaceholder* placeholder = qobject_cast<TabPlaceholder*>(this->ui->openEditorsTabWidget->widget(index))){
+            placeholder->askToSaveUnsavedText(this);
+        }
+        this->ui->openEditorsTabWidget->widget(index)->deleteLater();
         openEditor = qobject_cast<editor*>(this->ui->openEditorsTabWidget->currentWidget());
         // on closing a tab, delete a pointer (it manages its own data), and change the pointer to the current open tab
     });
@@ -610,14 +788,114 @@ void MainWindow::newTextFile()
     if(openFile(fileName)) getAllFilesInDirectory();
 }
 
+void MainWindow::setupAutoSaveMenu()
+{
+    // only one of the modes can be on, the group unchecks the others
+    QActionGroup* autoSaveGroup = new QActionGroup(this);
+    autoSaveGroup->setExclusive(true);
+
+    const std::pair<QAction*, autoSaveType> modes[] = {
+        {this->ui->actionNever_Auto_Save, autoSaveType::NeverAutoSave},
+        {this->ui->actionAuto_Save_On_Open, autoSaveType::SaveOnOpenNewFile},
+        {this->ui->actionAuto_Save_After_Delay, autoSaveType::SaveAfterDuratoion}
+    };
+    for(const auto& [action, mode] : modes){
+        autoSaveGroup->addAction(action);
+        action->setChecked(autoSaver->mode() == mode);
+        connect(action, &QAction::triggered, this, [this, mode = mode]{
+            autoSaver->setMode(mode);
+        });
+    }
+
+    connect(this->ui->actionAuto_Save_Delay, &QAction::triggered, this, [this]{
+        bool ok = false;
+        const int seconds = QInputDialog::getInt(this, tr("Auto Save Delay"), tr("Seconds after typing stops:"),
+                                                 autoSaver->delay() / 1000, 1, 3600, 1, &ok);
+        if(ok) autoSaver->setDelay(seconds * 1000);
+    });
+}
+
+void MainWindow::setupTerminalMenu()
+{
+    connect(this->ui->actionTerminal_Scrollback, &QAction::triggered, this, [this]{
+        bool ok = false;
+        const int lines = QInputDialog::getInt(this, tr("Terminal Scrollback"), tr("Lines kept in the terminal:"),
+                                               this->ui->terminalBox->scrollbackLines(), 100, 10000000, 1000, &ok);
+        if(ok) this->ui->terminalBox->setScrollbackLines(lines);
+    });
+}
+
+void MainWindow::setupMemoryMenu()
+{
+    connect(this->ui->actionTab_Memory_Budget, &QAction::triggered, this, [this]{
+        bool ok = false;
+        const int megabytes = QInputDialog::getInt(this, tr("Tab Memory Budget"), tr("Megabytes the open tabs can use:"),
+                                                   settings.tabMemoryBudget(), 16, 65536, 16, &ok);
+        if(!ok) return;
+        settings.setTabMemoryBudget(megabytes);
+        evictInactiveTabs(); // a lower budget applies right away
+    });
+}
+
 void MainWindow::showTerminal(){
     this->ui->terminalDockWidget->showNormal(); // if they press new terminal, it shows the widget
 }
 
+void MainWindow::showFindInFiles()
+{
+    if(this->ui->stackedWidget->currentIndex() == 0){
+        QMessageBox::warning(this, tr("Warning"), tr("Open a folder or a file to search in first"));
+        return;
+    }
+
+    // the opened folder as a whole, even after a file deeper in it was opened and moved currentDirectory there
+    const QString root = projectIndexer->root();
+    const QString directory = currentDirectory.absolutePath();
+    findInFiles->setFolder(!root.isEmpty() && (directory == root || directory.startsWith(root + "/")) ? root : directory);
+
+    // a selection on one line is most likely what they want to look for
+    QString selected;
+    if(openEditor != nullptr) selected = openEditor->getPte()->textCursor().selectedText();
+    if(selected.contains(QChar::ParagraphSeparator)) selected.clear();
+    findInFiles->showAndFocus(selected);
+}
+
+void MainWindow::openSearchResult(const QString& filePath, int line, int column, int length)
+{
+    editor* target = showFile(filePath);
+    if(target != nullptr) target->goToLine(line, column, length);
+}
+
+void MainWindow::showQuickOpen()
+{
+    if(projectIndexer->root().isEmpty()){
+        QMessageBox::warning(this, tr("Warning"), tr("Open a folder to go to its files first"));
+        return;
+    }
+    quickOpen->popup();
+}
+
+editor* MainWindow::showFile(const QString& filePath)
+{
+    QWidget* target = openFiles->tab(filePath);
+    if(target == nullptr){
+        if(!openFile(filePath)) return nullptr;
+        return openEditor;
+    }
+
+    this->ui->openEditorsTabWidget->setCurrentWidget(target); // a placeholder gets its editor as it becomes current
+    return openEditor;
+}
+
 void MainWindow::deleteAllTabs(){
     auto tabWidget = this->ui->openEditorsTabWidget;
+    const QSignalBlocker blocker(tabWidget); // otherwise every placeholder would get loaded as it became current on the way out
     while(tabWidget->count() != 0){
-        editor* cur = qobject_cast<editor*>(tabWidget->widget(0));
+        if(TabPlaceholder* placeholder = qobject_cast<TabPlaceholder*>(tabWidget->widget(0))){
+            placeholder->askToSaveUnsavedText(this); // an editor asks in its destructor
+        }
+
+        QWidget* cur = tabWidget->widget(0); // an editor, or a placeholder for a tab never shown
         tabWidget->removeTab(0);
         // cur->deleteLater();
         delete cur;
@@ -13,7 +13,15 @@
 #include <QTreeView>
 #include <QFileSystemModel>
 #include <QTextDocumentFragment>
+#include <QPointer>
 #include "editor.h"
+#include "autosaver.h"
+#include "runmanager.h"
+#include "projectindexer.h"
+#include "findinfilesdock.h"
+#include "quickopen.h"
+#include "settingshelper.h"
+#include "openfileregistry.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -28,6 +36,11 @@ class MainWindow : public QMainWindow
 public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
+
+    // looks for edit journals left behind by a crash and offers to reopen those files with the edits put back
+    void recoverUnsavedWork();
+    // reopens the folder and tabs from when the editor was last closed, only the current tab is read from disk
+    void restoreSession();
 protected:
     void closeEvent(QCloseEvent* event) override;
 private:
@@ -39,19 +52,31 @@ private:
     void connectSignals();
 
     void deleteAllTabs();
+    void setupAutoSaveMenu();
+    void setupTerminalMenu();
+    void setupMemoryMenu();
+
+    editor* showFile(const QString& filePath); // switches to its tab, opening it first if it isnt open, nullptr if it cant be
+    void loadIntoEditor(editor* page, QFile& file);
+    editor* materializeTab(int index); // swaps a TabPlaceholder at index for an editor with the file loaded
+    void currentTabChanged(int index);
+    void openFolder(const QString& dir);
+    // for recovered text whose file cant be opened anymore, offers to save it elsewhere, true if it was and got opened
+    bool saveRecoveredText(const QString& filePath, const QString& journalPath, const QString& text);
+    void saveSession();
+    void evictInactiveTabs(); // least recently shown first, until the open editors fit in the memory budget
+    void evictTab(editor* page);
 
 private slots:
     void openFileAction();
 
     void updateStatusBarCursorPosition(); // update the text of Line Number and Coloumn number on the bottom status bar
 
-    void on_StdoutAvailable(); // terminal output
-    void on_StderrAvailable(); // errors from the terminal
-
-    void writeToTerminal(); // pressing return in the line edit..
-
     void runButton();
     void showTerminal();
+    void showFindInFiles();
+    void openSearchResult(const QString& filePath, int line, int column, int length);
+    void showQuickOpen();
 
     void openFileWhileEditing(const QString& filePath);
 
@@ -72,11 +97,20 @@ private slots:
 
 private:
     Ui::MainWindow *ui;
-    QProcess *process;
 
     QFileSystemModel *fileModel; // the file explorer  on the left for treeview
 
     editor* openEditor = nullptr;
+    QList<QPointer<editor>> recentEditors; // every loaded editor, the most recently shown first
+    QPointer<editor> previousEditor; // the tab that was current before a switch, nullptr if it was closed
+
+    AutoSaver* autoSaver;
+    ProjectIndexer* projectIndexer; // every file under the opened folder
+    OpenFileRegistry* openFiles; // the tab for each open file, by canonical path
+    FindInFilesDock* findInFiles;
+    QuickOpen* quickOpen;
+    SettingsHelper settings;
+    RunManager* runManager;
 
     QLabel* lineAndColStatusLabel;
 
@@ -0,0 +1,499 @@
+#include "multicursor.h"
+#include "editor.h"
+#include <QApplication>
+#include <QClipboard>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QScrollBar>
+#include <QTextBlock>
+#include <algorithm>
+
+MultiCursor::MultiCursor(QPlainTextEdit* textEdit, SelectionLayers* layers, editor* page) :
+    QWidget(textEdit->viewport()),
+    textEdit(textEdit),
+    layers(layers),
+    page(page)
+{
+    setAttribute(Qt::WA_TransparentForMouseEvents); // clicks go through to the text edit, the filter sees them first
+    setGeometry(textEdit->viewport()->rect());
+
+    textEdit->installEventFilter(this);
+    textEdit->viewport()->installEventFilter(this);
+
+    // the viewport repainting (typing, scrolling, the cursor blinking) means the carets might have moved on screen
+    connect(textEdit, &QPlainTextEdit::updateRequest, this, [this]{ update(); });
+    connect(textEdit->verticalScrollBar(), &QScrollBar::valueChanged, this, &MultiCursor::refresh);
+}
+
+void MultiCursor::setCarets(const QVector<Caret>& newCarets)
+{
+    if(newCarets.isEmpty()) return;
+
+    commit(newCarets, newCarets.size() - 1);
+    textEdit->setFocus();
+}
+
+void MultiCursor::addCaret(const Caret& caret)
+{
+    qsizetype primaryIndex = 0;
+    QVector<Caret> all = allCarets(&primaryIndex);
+    all.append(caret);
+    const qsizetype newIndex = all.size() - 1;
+    commit(std::move(all), newIndex);
+}
+
+void MultiCursor::addCaretVertically(int direction)
+{
+    qsizetype primaryIndex = 0;
+    const QVector<Caret> all = allCarets(&primaryIndex);
+    const Caret& from = direction < 0 ? all.first() : all.last(); // sorted, so the topmost or bottommost
+
+    const QTextBlock block = textEdit->document()->findBlock(from.position);
+    const QTextBlock next = direction < 0 ? block.previous() : block.next();
+    if(!next.isValid()) return;
+
+    const int column = from.position - block.position();
+    const int position = next.position() + qMin(column, next.length() - 1);
+    addCaret(Caret{position, position});
+}
+
+void MultiCursor::addNextOccurrence()
+{
+    QTextCursor primary = textEdit->textCursor();
+    if(!primary.hasSelection()){
+        primary.select(QTextCursor::WordUnderCursor); // the first press only picks what to look for
+        textEdit->setTextCursor(primary);
+        return;
+    }
+
+    const QString text = primary.selectedText();
+    if(text.contains(QChar::ParagraphSeparator)) return; // find doesnt match across lines
+
+    qsizetype primaryIndex = 0;
+    const QVector<Caret> all = allCarets(&primaryIndex);
+    QTextDocument* document = textEdit->document();
+
+    // after the last caret, wrapping around to the top, skipping ones that are already selected
+    QTextCursor found = document->find(text, all.last().end(), QTextDocument::FindCaseSensitively);
+    if(found.isNull()) found = document->find(text, 0, QTextDocument::FindCaseSensitively);
+    while(!found.isNull()){
+        const int start = found.selectionStart();
+        const bool taken = std::any_of(all.cbegin(), all.cend(), [start](const Caret& caret){ return caret.start() == start; });
+        if(!taken){
+            addCaret(Caret{found.selectionStart(), found.selectionEnd()});
+            return;
+        }
+        if(found.selectionEnd() >= all.last().end()) return; // wrapped all the way around, every occurrence has a caret
+        found = document->find(text, found.selectionEnd(), QTextDocument::FindCaseSensitively);
+    }
+}
+
+void MultiCursor::clear()
+{
+    if(carets.isEmpty()) return;
+    carets.clear();
+    layers->clear(SelectionLayers::CursorSelections);
+    update();
+}
+
+void MultiCursor::documentChanged()
+{
+    if(!applying) clear();
+}
+
+QVector<MultiCursor::Caret> MultiCursor::allCarets(qsizetype* primaryIndex) const
+{
+    const QTextCursor cursor = textEdit->textCursor();
+    const Caret primary{cursor.anchor(), cursor.position()};
+
+    // carets is already sorted, the text edits cursor just goes in its place
+    const auto at = std::lower_bound(carets.cbegin(), carets.cend(), primary, [](const Caret& a, const Caret& b){
+        return a.start() < b.start() || (a.start() == b.start() && a.end() < b.end());
+    });
+    *primaryIndex = at - carets.cbegin();
+
+    QVector<Caret> all;
+    all.reserve(carets.size() + 1);
+    all.append(carets.cbegin(), at);
+    all.append(primary);
+    all.append(at, carets.cend());
+    return all;
+}
+
+void MultiCursor::commit(QVector<Caret> all, qsizetype primaryIndex)
+{
+    const Caret wanted = all.at(primaryIndex);
+    normalize(all);
+
+    // merging can swallow the main caret, then whichever one it ended up inside takes over
+    const auto exact = std::find_if(all.cbegin(), all.cend(), [wanted](const Caret& c){
+        return c.anchor == wanted.anchor && c.position == wanted.position;
+    });
+    const auto containing = std::find_if(all.cbegin(), all.cend(), [wanted](const Caret& c){
+        return c.start() <= wanted.position && wanted.position <= c.end();
+    });
+    primaryIndex = exact != all.cend() ? exact - all.cbegin() : (containing != all.cend() ? containing - all.cbegin() : 0);
+    const Caret primary = all.takeAt(primaryIndex);
+
+    QTextCursor cursor(textEdit->document());
+    cursor.setPosition(primary.anchor);
+    cursor.setPosition(primary.position, QTextCursor::KeepAnchor);
+    textEdit->setTextCursor(cursor);
+
+    carets = std::move(all);
+    refresh();
+}
+
+void MultiCursor::applyEdit(Edit edit, const QStringList& texts)
+{
+    qsizetype primaryIndex = 0;
+    QVector<Caret> all = allCarets(&primaryIndex);
+    const bool textPerCaret = texts.size() == all.size();
+
+    QTextDocument* document = textEdit->document();
+    const int documentEnd = document->characterCount() - 1;
+
+    // what each caret replaces, clamped so neighbours never overlap (a Delete right before another carets selection)
+    QVector<std::pair<int, int>> ranges;
+    ranges.reserve(all.size());
+    int previousEnd = 0;
+    for(const Caret& caret : std::as_const(all)){
+        int from = caret.start();
+        int to = caret.end();
+        if(from == to && edit == Edit::Backspace && from > 0){
+            from -= (from >= 2 && document->characterAt(from - 1).isLowSurrogate()) ? 2 : 1;
+        }
+        else if(from == to && edit == Edit::Delete && to < documentEnd){
+            to += (to + 1 < documentEnd && document->characterAt(to).isHighSurrogate()) ? 2 : 1;
+        }
+        from = qMax(from, previousEnd);
+        to = qMax(to, from);
+        ranges.append({from, to});
+        previousEnd = to;
+    }
+
+    // back to front, each edit only moves text after it, so the ranges still to go stay where they are
+    applying = true;
+    layers->clear(SelectionLayers::CursorSelections); // its cursors would each get moved on every single edit
+    QTextCursor cursor(document);
+    page->beginBatchedEdit();
+    cursor.beginEditBlock();
+    for(qsizetype i = ranges.size() - 1; i >= 0; --i){
+        const QString& text = textPerCaret ? texts.at(i) : texts.first();
+        const auto [from, to] = ranges.at(i);
+        if(from == to && text.isEmpty()) continue;
+
+        cursor.setPosition(from);
+        cursor.setPosition(to, QTextCursor::KeepAnchor);
+        if(text.isEmpty()) cursor.removeSelectedText();
+        else cursor.insertText(text);
+        page->recordBatchedEdit(from, to - from, cursor.position() - from); // the buffer follows back to front too
+    }
+    cursor.endEditBlock(); // the document and everything listening to it hear about one change here
+    page->endBatchedEdit();
+    applying = false;
+
+    // front to back, each caret ends up after its own text, shifted by what changed before it
+    int shift = 0;
+    for(qsizetype i = 0; i < ranges.size(); ++i){
+        const qsizetype length = (textPerCaret ? texts.at(i) : texts.first()).size();
+        const auto [from, to] = ranges.at(i);
+        const int position = int(from + shift + length);
+        all[i] = Caret{position, position};
+        shift += int(length) - (to - from);
+    }
+    commit(std::move(all), primaryIndex);
+}
+
+void MultiCursor::moveCarets(QTextCursor::MoveOperation operation, QTextCursor::MoveMode mode)
+{
+    qsizetype primaryIndex = 0;
+    QVector<Caret> all = allCarets(&primaryIndex);
+
+    // one cursor reused for all of them, nothing is edited so it costs a lookup each
+    QTextCursor cursor(textEdit->document());
+    for(Caret& caret : all){
+        if(mode == QTextCursor::MoveAnchor && caret.anchor != caret.position
+            && (operation == QTextCursor::PreviousCharacter || operation == QTextCursor::NextCharacter)){
+            // an arrow on a selection just drops it on that side, like the text edit does
+            const int side = operation == QTextCursor::PreviousCharacter ? caret.start() : caret.end();
+            caret = Caret{side, side};
+            continue;
+        }
+        cursor.setPosition(caret.anchor);
+        cursor.setPosition(caret.position, QTextCursor::KeepAnchor);
+        cursor.movePosition(operation, mode);
+        caret = Caret{cursor.anchor(), cursor.position()};
+    }
+    commit(std::move(all), primaryIndex);
+}
+
+void MultiCursor::copySelections(bool cut)
+{
+    qsizetype primaryIndex = 0;
+    const QVector<Caret> all = allCarets(&primaryIndex);
+
+    QStringList selected;
+    QTextCursor cursor(textEdit->document());
+    for(const Caret& caret : all){
+        if(caret.anchor == caret.position) continue;
+        cursor.setPosition(caret.start());
+        cursor.setPosition(caret.end(), QTextCursor::KeepAnchor);
+        selected.append(cursor.selectedText().replace(QChar::ParagraphSeparator, u'\n'));
+    }
+    if(selected.isEmpty()) return;
+
+    QApplication::clipboard()->setText(selected.join(u'\n')); // one line each, pasting back into as many carets splits it again
+    if(cut) applyEdit(Edit::Insert, {QString()});
+}
+
+void MultiCursor::paste()
+{
+    QString text = QApplication::clipboard()->text();
+    text.replace("\r\n", "\n"); // insertText makes a new line out of each of them
+
+    const QStringList lines = text.split(u'\n');
+    if(lines.size() == count()) applyEdit(Edit::Insert, lines); // a line for each caret
+    else applyEdit(Edit::Insert, {text});
+}
+
+bool MultiCursor::eventFilter(QObject* watched, QEvent* event)
+{
+    if(watched == textEdit->viewport()){
+        if(event->type() == QEvent::Resize) setGeometry(textEdit->viewport()->rect());
+        return handleMouse(event);
+    }
+    if(watched != textEdit) return false;
+
+    if(event->type() == QEvent::ShortcutOverride && isHandledKey(static_cast<QKeyEvent*>(event))){
+        event->accept(); // comes in as a key press instead of going to a menu action
+        return true;
+    }
+    if(event->type() == QEvent::KeyPress) return handleKey(static_cast<QKeyEvent*>(event));
+    return false;
+}
+
+bool MultiCursor::isHandledKey(const QKeyEvent* event) const
+{
+    const Qt::KeyboardModifiers modifiers = event->modifiers() & ~Qt::KeypadModifier;
+    if(event->key() == Qt::Key_D && modifiers == Qt::ControlModifier) return true;
+    if((event->key() == Qt::Key_Up || event->key() == Qt::Key_Down) && modifiers == (Qt::ControlModifier | Qt::AltModifier)) return true;
+    if(!isActive()) return false;
+
+    return event->key() == Qt::Key_Escape
+        || (modifiers == Qt::ControlModifier && (event->key() == Qt::Key_C || event->key() == Qt::Key_X || event->key() == Qt::Key_V));
+}
+
+bool MultiCursor::handleKey(QKeyEvent* event)
+{
+    const Qt::KeyboardModifiers modifiers = event->modifiers() & ~Qt::KeypadModifier;
+    const bool control = modifiers.testFlag(Qt::ControlModifier);
+
+    // spawning carets works with or without any already there
+    if(event->key() == Qt::Key_D && modifiers == Qt::ControlModifier){
+        addNextOccurrence();
+        return true;
+    }
+    if((event->key() == Qt::Key_Up || event->key() == Qt::Key_Down) && modifiers == (Qt::ControlModifier | Qt::AltModifier)){
+        addCaretVertically(event->key() == Qt::Key_Up ? -1 : 1);
+        return true;
+    }
+    if(!isActive()) return false;
+
+    const QTextCursor::MoveMode mode = modifiers.testFlag(Qt::ShiftModifier) ? QTextCursor::KeepAnchor : QTextCursor::MoveAnchor;
+    switch(event->key()){
+    case Qt::Key_Escape:
+        clear();
+        return true;
+    case Qt::Key_Backspace:
+        applyEdit(Edit::Backspace, {QString()});
+        return true;
+    case Qt::Key_Delete:
+        applyEdit(Edit::Delete, {QString()});
+        return true;
+    case Qt::Key_Return:
+    case Qt::Key_Enter:
+        applyEdit(Edit::Insert, {QString(u'\n')});
+        return true;
+    case Qt::Key_Tab:
+        applyEdit(Edit::Insert, {QString(u'\t')});
+        return true;
+    case Qt::Key_Left:
+        moveCarets(control ? QTextCursor::PreviousWord : QTextCursor::PreviousCharacter, mode);
+        return true;
+    case Qt::Key_Right:
+        moveCarets(control ? QTextCursor::NextWord : QTextCursor::NextCharacter, mode);
+        return true;
+    case Qt::Key_Up:
+        moveCarets(QTextCursor::Up, mode);
+        return true;
+    case Qt::Key_Down:
+        moveCarets(QTextCursor::Down, mode);
+        return true;
+    case Qt::Key_Home:
+        moveCarets(QTextCursor::StartOfLine, mode);
+        return true;
+    case Qt::Key_End:
+        moveCarets(QTextCursor::EndOfLine, mode);
+        return true;
+    default:
+        break;
+    }
+
+    if(modifiers == Qt::ControlModifier){
+        switch(event->key()){
+        case Qt::Key_C:
+            copySelections(false);
+            return true;
+        case Qt::Key_X:
+            copySelections(true);
+            return true;
+        case Qt::Key_V:
+            paste();
+            return true;
+        case Qt::Key_A:
+            clear(); // select all is for the one cursor
+            return false;
+        default:
+            return false; // anything else goes to the main cursor, if it edits the text the extra carets go away
+        }
+    }
+
+    // ctrl and alt together is AltGr on some layouts, that still types
+    const bool command = (control && !modifiers.testFlag(Qt::AltModifier)) || modifiers.testFlag(Qt::MetaModifier);
+    const QString text = event->text();
+    if(command || text.isEmpty() || !text.at(0).isPrint()) return false;
+
+    applyEdit(Edit::Insert, {text});
+    return true;
+}
+
+bool MultiCursor::handleMouse(QEvent* event)
+{
+    if(event->type() != QEvent::MouseButtonPress && event->type() != QEvent::MouseMove && event->type() != QEvent::MouseButtonRelease){
+        return false;
+    }
+    const QMouseEvent* mouseEvent = static_cast<QMouseEvent*>(event);
+    const Qt::KeyboardModifiers modifiers = mouseEvent->modifiers();
+
+    if(event->type() == QEvent::MouseButtonPress){
+        if(mouseEvent->button() != Qt::LeftButton) return false;
+
+        if(modifiers == (Qt::AltModifier | Qt::ShiftModifier)){
+            // a column, from here to wherever the drag goes
+            const QTextCursor at = textEdit->cursorForPosition(mouseEvent->position().toPoint());
+            columnSelecting = true;
+            columnStartBlock = at.blockNumber();
+            columnStartColumn = at.positionInBlock();
+            columnSelect(mouseEvent->position().toPoint());
+            return true;
+        }
+        if(modifiers == Qt::AltModifier){
+            const int position = textEdit->cursorForPosition(mouseEvent->position().toPoint()).position();
+            addCaret(Caret{position, position});
+            return true;
+        }
+        clear(); // a plain click goes back to one cursor
+        return false;
+    }
+
+    if(!columnSelecting) return false;
+    if(event->type() == QEvent::MouseMove) columnSelect(mouseEvent->position().toPoint());
+    else columnSelecting = false;
+    return true;
+}
+
+void MultiCursor::columnSelect(const QPoint& to)
+{
+    const QTextCursor end = textEdit->cursorForPosition(to);
+    const int endColumn = end.positionInBlock();
+    const int step = end.blockNumber() >= columnStartBlock ? 1 : -1;
+
+    QVector<Caret> column;
+    column.reserve(qAbs(end.blockNumber() - columnStartBlock) + 1);
+    QTextBlock block = textEdit->document()->findBlockByNumber(columnStartBlock);
+    while(block.isValid()){
+        const int lineLength = block.length() - 1;
+        column.append(Caret{block.position() + qMin(columnStartColumn, lineLength), block.position() + qMin(endColumn, lineLength)});
+        if(block.blockNumber() == end.blockNumber()) break;
+        block = step > 0 ? block.next() : block.previous();
+    }
+
+    carets.clear(); // the column replaces whatever carets there were
+    const qsizetype last = column.size() - 1;
+    commit(std::move(column), last); // the main cursor follows the mouse
+}
+
+void MultiCursor::refresh()
+{
+    if(carets.isEmpty()){
+        layers->clear(SelectionLayers::CursorSelections);
+        update();
+        return;
+    }
+
+    // carets are sorted, the ones on screen are one run
+    const auto [firstVisible, lastVisible] = visibleRange();
+    auto caret = std::partition_point(carets.cbegin(), carets.cend(), [firstVisible](const Caret& c){ return c.end() < firstVisible; });
+
+    QList<QTextEdit::ExtraSelection> selections;
+    for(; caret != carets.cend() && caret->start() <= lastVisible; ++caret){
+        if(caret->anchor == caret->position) continue;
+
+        QTextEdit::ExtraSelection selection;
+        selection.cursor = QTextCursor(textEdit->document());
+        selection.cursor.setPosition(caret->anchor);
+        selection.cursor.setPosition(caret->position, QTextCursor::KeepAnchor);
+        selection.format.setBackground(textEdit->palette().highlight());
+        selection.format.setForeground(textEdit->palette().highlightedText());
+        selections.append(selection);
+    }
+    layers->set(SelectionLayers::CursorSelections, selections);
+    update();
+}
+
+std::pair<int, int> MultiCursor::visibleRange() const
+{
+    const int first = textEdit->cursorForPosition(QPoint(0, 0)).block().position();
+    const QTextBlock lastBlock = textEdit->cursorForPosition(QPoint(0, textEdit->viewport()->height() - 1)).block();
+    return {first, lastBlock.position() + lastBlock.length()};
+}
+
+void MultiCursor::paintEvent(QPaintEvent*)
+{
+    if(carets.isEmpty()) return;
+
+    QPainter painter(this);
+    const QColor color = textEdit->palette().text().color();
+    const int width = qMax(1, textEdit->cursorWidth());
+
+    const auto [firstVisible, lastVisible] = visibleRange();
+    auto caret = std::partition_point(carets.cbegin(), carets.cend(), [firstVisible](const Caret& c){ return c.end() < firstVisible; });
+    QTextCursor cursor(textEdit->document());
+    for(; caret != carets.cend() && caret->start() <= lastVisible; ++caret){
+        cursor.setPosition(caret->position);
+        const QRect rect = textEdit->cursorRect(cursor);
+        painter.fillRect(rect.x(), rect.y(), width, rect.height(), color);
+    }
+}
+
+void MultiCursor::normalize(QVector<Caret>& all)
+{
+    std::sort(all.begin(), all.end(), [](const Caret& a, const Caret& b){
+        return a.start() < b.start() || (a.start() == b.start() && a.end() < b.end());
+    });
+
+    qsizetype kept = 0;
+    for(qsizetype i = 0; i < all.size(); ++i){
+        if(kept > 0){
+            Caret& previous = all[kept - 1];
+            if(all.at(i).start() < previous.end() || all.at(i).start() == previous.start()){
+                if(all.at(i).end() > previous.end()) previous = Caret{previous.start(), all.at(i).end()};
+                continue;
+            }
+        }
+        all[kept++] = all.at(i);
+    }
+    all.resize(kept);
+}
@@ -0,0 +1,102 @@
+#ifndef MULTICURSOR_H
+#define MULTICURSOR_H
+
+#include <QWidget>
+#include <QPlainTextEdit>
+#include <QVector>
+#include "selectionlayers.h"
+
+class QKeyEvent;
+class QMouseEvent;
+class editor;
+
+// extra cursors on top of the text edits own one, from Alt+click, Alt+Shift+drag (a column), Ctrl+Alt+Up/Down,
+// Ctrl+D (the next occurrence of the selection) or every search result at once
+// the carets are kept as plain positions and not QTextCursors, the document moves every live cursor on every edit
+// so typing into n of them would cost n squared. an edit goes to all the carets inside one edit block, back to front
+// so the ones not reached yet dont move, and their new positions come from the lengths in one pass after. the text
+// edit sees it as a single change (one undo step), the piece table and the journal get each caret's edit on its own
+// through the editors batched edits, so their cost doesnt depend on how far apart the carets are
+// this is a transparent widget over the text edits viewport that paints the extra carets, their selections go in a
+// layer of extra selections, both only for whats on screen
+class MultiCursor : public QWidget
+{
+public:
+    struct Caret
+    {
+        int anchor = 0;
+        int position = 0;
+
+        inline int start() const
+        {
+            return qMin(anchor, position);
+        }
+        inline int end() const
+        {
+            return qMax(anchor, position);
+        }
+    };
+
+    MultiCursor(QPlainTextEdit* textEdit, SelectionLayers* layers, editor* page);
+
+    inline bool isActive() const
+    {
+        return !carets.isEmpty();
+    }
+    inline qsizetype count() const // along with the text edits own cursor
+    {
+        return carets.size() + 1;
+    }
+
+    // replaces any extra carets, the last one becomes the text edits own cursor
+    void setCarets(const QVector<Caret>& newCarets);
+    void addCaret(const Caret& caret); // becomes the text edits cursor, the old one stays as an extra
+    void addCaretVertically(int direction); // -1 on the line above the topmost caret, 1 below the bottommost
+    void addNextOccurrence(); // selects the word first if nothing is selected
+    void clear();
+
+    void documentChanged(); // the text changed, anything that didnt come through here leaves the positions meaningless
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
+    void paintEvent(QPaintEvent* event) override;
+
+private:
+    enum class Edit{
+        Insert, // replaces each selection, or goes at each caret
+        Backspace,
+        Delete
+    };
+
+    QVector<Caret> allCarets(qsizetype* primaryIndex) const; // the extras and the text edits own, sorted
+    void commit(QVector<Caret> all, qsizetype primaryIndex); // merges overlaps and hands the main one back to the text edit
+
+    // one text for every caret, or one for each when there are as many as carets
+    void applyEdit(Edit edit, const QStringList& texts);
+    void moveCarets(QTextCursor::MoveOperation operation, QTextCursor::MoveMode mode);
+    void copySelections(bool cut);
+    void paste();
+
+    bool handleKey(QKeyEvent* event); // true when its been done for every caret
+    bool isHandledKey(const QKeyEvent* event) const; // so it wins over menu shortcuts
+    bool handleMouse(QEvent* event);
+    void columnSelect(const QPoint& to);
+
+    void refresh(); // the selection layer and a repaint, for the carets on screen
+    std::pair<int, int> visibleRange() const; // document positions
+
+    static void normalize(QVector<Caret>& all); // sorts and merges carets that overlap
+
+private:
+    QPlainTextEdit* textEdit; // non-owning
+    SelectionLayers* layers; // non-owning
+    editor* page; // non-owning, the edits go into its buffer and journal one by one
+    QVector<Caret> carets; // the extra ones sorted by start, the text edits own cursor isnt in here
+    bool applying = false; // its own edits dont clear the carets
+
+    bool columnSelecting = false;
+    int columnStartBlock = 0;
+    int columnStartColumn = 0; // characters into the line, shorter lines get a caret at their end
+};
+
+#endif // MULTICURSOR_H
@@ -0,0 +1,97 @@
+#include "openfileregistry.h"
+#include "editor.h"
+#include <QDir>
+#include <QFileInfo>
+
+OpenFileRegistry::OpenFileRegistry(QObject* parent) :
+    QObject(parent)
+{
+}
+
+QString OpenFileRegistry::canonicalPath(const QString& filePath)
+{
+    const QFileInfo info(filePath);
+    const QString canonical = info.canonicalFilePath(); // empty if it doesnt exist
+    return canonical.isEmpty() ? QDir::cleanPath(info.absoluteFilePath()) : canonical;
+}
+
+void OpenFileRegistry::add(const QString& filePath, QWidget* tab)
+{
+    const QString path = canonicalPath(filePath);
+    remove(documents.value(path).tab); // a second tab on the same file replaces the first here
+
+    OpenDocument document;
+    document.filePath = path;
+    document.tab = tab;
+    documents.insert(path, document);
+    tabPaths.insert(tab, path);
+    watch(tab);
+}
+
+void OpenFileRegistry::replaceTab(QWidget* oldTab, QWidget* newTab)
+{
+    const QString path = tabPaths.take(oldTab);
+    if(path.isEmpty()) return;
+
+    disconnect(oldTab, nullptr, this, nullptr); // its destroyed shouldnt take the entry with it
+    documents[path].tab = newTab; // the metadata carries over, its the same file
+    tabPaths.insert(newTab, path);
+    watch(newTab);
+}
+
+QWidget* OpenFileRegistry::tab(const QString& filePath) const
+{
+    const OpenDocument* found = document(filePath);
+    return found != nullptr ? found->tab.data() : nullptr;
+}
+
+const OpenDocument* OpenFileRegistry::document(const QString& filePath) const
+{
+    const auto found = documents.constFind(canonicalPath(filePath));
+    return found != documents.cend() ? &*found : nullptr;
+}
+
+void OpenFileRegistry::watch(QWidget* tab)
+{
+    connect(tab, &QObject::destroyed, this, [this](QObject* object){ remove(object); });
+
+    const editor* page = qobject_cast<editor*>(tab);
+    if(page == nullptr) return;
+    connect(page, &editor::loaded, this, [this, page]{ loaded(page); });
+    connect(page, &editor::fileRenamed, this, [this, page](const QString& newPath){ rename(page, newPath); });
+}
+
+void OpenFileRegistry::remove(const QObject* tab)
+{
+    if(tab == nullptr) return;
+    const QString path = tabPaths.take(tab);
+    if(path.isEmpty()) return;
+
+    // only if its still the tab registered for it, a save as onto an open file can leave an older entry there
+    const auto found = documents.find(path);
+    if(found != documents.end() && found->tab == tab) documents.erase(found);
+}
+
+void OpenFileRegistry::rename(const QObject* tab, const QString& newPath)
+{
+    const QString oldPath = tabPaths.value(tab);
+    const QString path = canonicalPath(newPath);
+    if(oldPath.isEmpty() || oldPath == path) return;
+
+    OpenDocument document = documents.take(oldPath);
+    document.filePath = path;
+    documents.insert(path, document);
+    tabPaths.insert(tab, path);
+}
+
+void OpenFileRegistry::loaded(const QObject* tab)
+{
+    const auto found = documents.find(tabPaths.value(tab));
+    if(found == documents.end()) return;
+
+    const editor::LoadInfo& info = static_cast<const editor*>(tab)->loadInfo();
+    found->size = info.size;
+    found->encoding = info.encoding;
+    found->loadMilliseconds = info.milliseconds;
+    found->loadedAt = QDateTime::currentDateTime();
+}
@@ -0,0 +1,52 @@
+#ifndef OPENFILEREGISTRY_H
+#define OPENFILEREGISTRY_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QHash>
+#include <QPointer>
+#include <QWidget>
+
+struct OpenDocument
+{
+    QString filePath; // canonical
+    QPointer<QWidget> tab; // the editor, or a TabPlaceholder while it isnt loaded
+    qint64 size = -1; // bytes on disk when it was last loaded, -1 until it has been
+    QString encoding; // what it was decoded from
+    qint64 loadMilliseconds = -1; // reading it in and filling the document
+    QDateTime loadedAt;
+};
+
+// every file open in a tab, keyed by its canonical path so a symlink, a relative path or one with .. in it all
+// find the same tab with one hash lookup instead of walking the widget tree. a tab drops out on its own when its
+// destroyed, and the editors report their load metadata and save as renames straight to this
+class OpenFileRegistry : public QObject
+{
+public:
+    explicit OpenFileRegistry(QObject* parent);
+
+    // the resolved path, or the cleaned absolute one for a file that doesnt exist (yet)
+    static QString canonicalPath(const QString& filePath);
+
+    void add(const QString& filePath, QWidget* tab);
+    void replaceTab(QWidget* oldTab, QWidget* newTab); // a placeholder swapped for its editor, or the other way
+
+    QWidget* tab(const QString& filePath) const; // nullptr if the file isnt open
+    const OpenDocument* document(const QString& filePath) const; // same, with the metadata
+    inline qsizetype count() const
+    {
+        return documents.size();
+    }
+
+private:
+    void watch(QWidget* tab);
+    void remove(const QObject* tab);
+    void rename(const QObject* tab, const QString& newPath);
+    void loaded(const QObject* tab);
+
+private:
+    QHash<QString, OpenDocument> documents; // by canonical path
+    QHash<const QObject*, QString> tabPaths; // the other way round, for tabs that get destroyed or renamed
+};
+
+#endif // OPENFILEREGISTRY_H
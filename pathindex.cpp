@@ -0,0 +1,266 @@
+#include "pathindex.h"
+#include <QVarLengthArray>
+#include <algorithm>
+#include <iterator>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PATHINDEX_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr int scoreMatch = 16;
+constexpr int bonusFirstCharacter = 10; // the start of the file name (or the path)
+constexpr int bonusBoundary = 8; // right after a separator
+constexpr int bonusCamelCase = 7;
+constexpr int bonusConsecutive = 6;
+constexpr int bonusFileName = 30; // the whole query matched inside the file name
+constexpr int penaltyGapStart = 3;
+constexpr int penaltyGapExtension = 1;
+
+inline bool isSeparator(QChar c)
+{
+    return c == u'/' || c == u'_' || c == u'-' || c == u'.' || c == u' ';
+}
+
+// lowercases one utf 16 unit at a time, QString::toLower can change the length (U+0130 becomes i plus a combining dot)
+// and the scoring indexes the original path with positions from the lowercased one, so they have to line up
+QString lowerPerUnit(QStringView text)
+{
+    QString lower(text.size(), Qt::Uninitialized);
+    QChar* out = lower.data();
+    for(const QChar c : text) *out++ = c.toLower();
+    return lower;
+}
+
+// like fzf's first pass: the earliest place the whole query has matched, then back from there to the latest start,
+// which gives a tight window instead of one stretched from the first possible character
+int scoreSubsequence(QStringView query, QStringView lower, QStringView original)
+{
+    const qsizetype queryLength = query.size();
+
+    qsizetype end = -1;
+    for(qsizetype i = 0, j = 0; i < lower.size(); ++i){
+        if(lower[i] == query[j] && ++j == queryLength){
+            end = i;
+            break;
+        }
+    }
+    if(end < 0) return -1;
+
+    qsizetype start = end;
+    for(qsizetype i = end, j = queryLength - 1; i >= 0; --i){
+        if(lower[i] != query[j]) continue;
+        if(j == 0){
+            start = i;
+            break;
+        }
+        --j;
+    }
+
+    int score = 0;
+    bool inGap = false;
+    for(qsizetype i = start, j = 0; i <= end && j < queryLength; ++i){
+        if(lower[i] != query[j]){
+            score -= inGap ? penaltyGapExtension : penaltyGapStart;
+            inGap = true;
+            continue;
+        }
+
+        score += scoreMatch;
+        if(i == 0) score += bonusFirstCharacter;
+        else if(isSeparator(original[i - 1])) score += bonusBoundary;
+        else if(original[i].isUpper() && original[i - 1].isLower()) score += bonusCamelCase;
+        if(j > 0 && !inGap) score += bonusConsecutive;
+
+        inGap = false;
+        ++j;
+    }
+    return score;
+}
+
+} // namespace
+
+PathIndex::PathIndex(const QStringList& initialPaths)
+{
+    paths.reserve(initialPaths.size());
+    lowerPaths.reserve(initialPaths.size());
+    nameStarts.reserve(initialPaths.size());
+    masks.reserve(size_t(initialPaths.size()));
+    ids.reserve(initialPaths.size());
+    for(const QString& path : initialPaths) add(path);
+}
+
+void PathIndex::add(const QString& path)
+{
+    if(ids.contains(path)) return; // changed contents, the path is the same
+
+    const int id = int(paths.size());
+    const QString lower = lowerPerUnit(path);
+    const qsizetype nameStart = path.lastIndexOf(u'/') + 1;
+
+    paths.append(path);
+    lowerPaths.append(lower);
+    nameStarts.append(int(nameStart));
+    masks.push_back(characterMask(lower));
+    ids.insert(path, id);
+    ++liveCount;
+
+    QVarLengthArray<quint64, 64> seen; // a name like "aaaa.txt" should only list the id once per trigram
+    for(qsizetype i = nameStart; i + 3 <= lower.size(); ++i){
+        const quint64 key = trigramKey(lower, i);
+        if(std::find(seen.cbegin(), seen.cend(), key) != seen.cend()) continue;
+        seen.append(key);
+        trigrams[key].append(id); // ids only grow, so every list stays sorted
+    }
+
+    lastMatchesComplete = false; // the new path wasnt there to match the last query
+}
+
+void PathIndex::remove(const QString& path)
+{
+    const auto found = ids.constFind(path);
+    if(found == ids.cend()) return;
+
+    const int id = *found;
+    ids.erase(found);
+    masks[size_t(id)] = 0; // the trigram lists still have it, candidates are checked against this
+    --liveCount;
+    // lastMatches can keep it, a zero mask never passes again
+}
+
+QVector<PathIndex::Match> PathIndex::find(const QString& text, int limit)
+{
+    QString query = lowerPerUnit(text); // folded the same way as the paths
+    query.remove(u' ');
+    query.replace(u'\\', u'/');
+    if(query.isEmpty() || limit <= 0) return {};
+
+    const quint64 queryMask = characterMask(query);
+
+    QVector<int> candidates;
+    bool complete = true;
+    if(lastMatchesComplete && !lastQuery.isEmpty() && query.startsWith(lastQuery)){
+        candidates = maskCandidates(queryMask, &lastMatches); // anything matching this query matched the last one
+    }
+    else{
+        if(query.size() >= 3){
+            QVector<int> containing = trigramCandidates(query);
+            if(containing.size() >= limit){
+                // enough file names have the query in them outright, those outrank anything matched loosely
+                candidates = std::move(containing);
+                complete = false;
+            }
+        }
+        if(complete) candidates = maskCandidates(queryMask, nullptr);
+    }
+
+    QVector<Match> matches;
+    QVector<int> matchedIds;
+    matches.reserve(candidates.size());
+    matchedIds.reserve(candidates.size());
+    for(const int id : std::as_const(candidates)){
+        const int matchScore = score(query, lowerPaths.at(id), paths.at(id), nameStarts.at(id));
+        if(matchScore < 0) continue;
+        matches.append(Match{id, matchScore});
+        matchedIds.append(id);
+    }
+
+    lastQuery = query;
+    lastMatches = std::move(matchedIds);
+    lastMatchesComplete = complete;
+
+    // only the top few get sorted, shorter paths first when the scores tie
+    const auto better = [this](const Match& a, const Match& b){
+        if(a.score != b.score) return a.score > b.score;
+        if(paths.at(a.id).size() != paths.at(b.id).size()) return paths.at(a.id).size() < paths.at(b.id).size();
+        return paths.at(a.id) < paths.at(b.id);
+    };
+    const qsizetype shown = qMin<qsizetype>(limit, matches.size());
+    std::partial_sort(matches.begin(), matches.begin() + shown, matches.end(), better);
+    matches.resize(shown);
+    return matches;
+}
+
+int PathIndex::score(QStringView query, QStringView lowerPath, QStringView path, qsizetype nameStart)
+{
+    const int inName = scoreSubsequence(query, lowerPath.mid(nameStart), path.mid(nameStart));
+    if(inName >= 0) return inName + bonusFileName;
+    return scoreSubsequence(query, lowerPath, path);
+}
+
+quint64 PathIndex::characterMask(QStringView lowerText)
+{
+    quint64 mask = 0;
+    for(const QChar c : lowerText){
+        const char16_t unit = c.unicode();
+        if(unit >= u'a' && unit <= u'z') mask |= quint64(1) << (unit - u'a');
+        else if(unit >= u'0' && unit <= u'9') mask |= quint64(1) << (26 + unit - u'0');
+        else if(unit == u'/') mask |= quint64(1) << 36;
+        else if(unit == u'.') mask |= quint64(1) << 37;
+        else if(unit == u'_') mask |= quint64(1) << 38;
+        else if(unit == u'-') mask |= quint64(1) << 39;
+        else if(unit < 0x80) mask |= quint64(1) << 62; // any other ascii
+        else mask |= quint64(1) << 63; // anything else, only says theres some non ascii in there
+    }
+    return mask;
+}
+
+quint64 PathIndex::trigramKey(QStringView text, qsizetype position)
+{
+    return (quint64(text[position].unicode()) << 32) | (quint64(text[position + 1].unicode()) << 16) | text[position + 2].unicode();
+}
+
+QVector<int> PathIndex::trigramCandidates(QStringView query) const
+{
+    QVector<const QVector<int>*> lists;
+    for(qsizetype i = 0; i + 3 <= query.size(); ++i){
+        const auto found = trigrams.constFind(trigramKey(query, i));
+        if(found == trigrams.cend()) return {}; // no file name has this part of the query in it
+        lists.append(&*found);
+    }
+
+    // the shortest list first, everything after only narrows it down
+    std::sort(lists.begin(), lists.end(), [](const QVector<int>* a, const QVector<int>* b){ return a->size() < b->size(); });
+
+    QVector<int> result;
+    for(const int id : *lists.first()){
+        if(masks[size_t(id)] != 0) result.append(id);
+    }
+    for(qsizetype i = 1; i < lists.size() && !result.isEmpty(); ++i){
+        QVector<int> narrowed;
+        std::set_intersection(result.cbegin(), result.cend(), lists.at(i)->cbegin(), lists.at(i)->cend(), std::back_inserter(narrowed));
+        result = std::move(narrowed);
+    }
+    return result;
+}
+
+QVector<int> PathIndex::maskCandidates(quint64 queryMask, const QVector<int>* within) const
+{
+    QVector<int> candidates;
+
+    if(within != nullptr){
+        for(const int id : *within){
+            if((masks[size_t(id)] & queryMask) == queryMask) candidates.append(id);
+        }
+        return candidates;
+    }
+
+    const qsizetype count = qsizetype(masks.size());
+    qsizetype i = 0;
+#if defined(PATHINDEX_SSE2)
+    // two masks per register, a path passes when both 32 bit halves of its lane equal the query after the AND
+    const __m128i wanted = _mm_set1_epi64x(qint64(queryMask));
+    for(; i + 2 <= count; i += 2){
+        const __m128i lanes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(masks.data() + i));
+        const int equal = _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(lanes, wanted), wanted));
+        if((equal & 0x00FF) == 0x00FF) candidates.append(int(i));
+        if((equal & 0xFF00) == 0xFF00) candidates.append(int(i + 1));
+    }
+#endif
+    for(; i < count; ++i){
+        if((masks[size_t(i)] & queryMask) == queryMask) candidates.append(int(i));
+    }
+    return candidates;
+}
@@ -0,0 +1,71 @@
+#ifndef PATHINDEX_H
+#define PATHINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QVector>
+#include <vector>
+
+// the paths quick open searches, and the fuzzy matching over them
+// a path matches if the query is a subsequence of it (case insensitive). every path has a 64 bit mask of which
+// characters it has, so most paths get ruled out by one AND against the querys mask, done two paths at a time with
+// sse2. longer queries first try a trigram index of the file names, which gives the paths that contain the query
+// outright without looking at the rest. the matches of the last query are kept, so typing another character only
+// rescores those. doesnt touch any gui objects, so it can be built on any thread
+class PathIndex
+{
+public:
+    struct Match
+    {
+        int id;
+        int score;
+    };
+
+    PathIndex() = default;
+    explicit PathIndex(const QStringList& paths);
+
+    void add(const QString& path);
+    void remove(const QString& path);
+
+    inline qsizetype size() const
+    {
+        return liveCount;
+    }
+    inline qsizetype removedCount() const // still taking up space until the index is rebuilt
+    {
+        return qsizetype(masks.size()) - liveCount;
+    }
+    inline const QString& path(int id) const
+    {
+        return paths.at(id);
+    }
+
+    // the best matches first, at most limit of them
+    QVector<Match> find(const QString& query, int limit);
+
+    // higher is better, -1 if its not a match. query has to be lowercase already
+    static int score(QStringView query, QStringView lowerPath, QStringView path, qsizetype nameStart);
+
+private:
+    static quint64 characterMask(QStringView lowerText);
+    static quint64 trigramKey(QStringView text, qsizetype position);
+    QVector<int> trigramCandidates(QStringView query) const;
+    QVector<int> maskCandidates(quint64 queryMask, const QVector<int>* within) const;
+
+private:
+    QStringList paths; // by id, removed ones are left in place until a rebuild
+    QStringList lowerPaths;
+    QVector<int> nameStarts; // where the file name starts in each path
+    std::vector<quint64> masks; // contiguous for the vectorized scan, 0 for a removed path so it never passes
+    QHash<QString, int> ids;
+    QHash<quint64, QVector<int>> trigrams; // of the lowercased file names, each list sorted by id
+    qsizetype liveCount = 0;
+
+    // every path that matched the last query, the next query only needs to look at these if it starts with it
+    QString lastQuery;
+    QVector<int> lastMatches;
+    bool lastMatchesComplete = false;
+};
+
+#endif // PATHINDEX_H
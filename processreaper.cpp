@@ -0,0 +1,90 @@
+#include "processreaper.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QThread>
+#include <QTimer>
+
+#ifndef _WIN32
+#include "childwatcher.h"
+#include <signal.h>
+
+namespace {
+
+void signalGroup(pid_t pid, int signal)
+{
+    ::kill(-pid, signal); // fails harmlessly if pid doesnt lead a group
+    ::kill(pid, signal);
+}
+
+} // namespace
+#endif
+
+ProcessReaper::ProcessReaper(QObject* parent) :
+    QObject(parent)
+{
+}
+
+ProcessReaper* ProcessReaper::instance()
+{
+    static QPointer<ProcessReaper> reaper;
+    if(reaper == nullptr) reaper = new ProcessReaper(QCoreApplication::instance());
+    return reaper;
+}
+
+#ifndef _WIN32
+void ProcessReaper::adopt(pid_t pid)
+{
+    signalGroup(pid, SIGHUP);
+
+    ChildWatcher* watcher = new ChildWatcher(pid, this);
+    connect(watcher, &ChildWatcher::exited, watcher, &QObject::deleteLater);
+
+    // the timers go away with the watcher, so nothing gets signalled after its reaped (and the pid maybe reused)
+    QTimer::singleShot(terminateAfter, watcher, [watcher]{
+        if(!watcher->tryReap()) signalGroup(watcher->pid(), SIGTERM);
+    });
+    QTimer::singleShot(killAfter, watcher, [watcher]{
+        if(!watcher->tryReap()) signalGroup(watcher->pid(), SIGKILL);
+    });
+}
+#endif
+
+void ProcessReaper::adopt(QProcess* process, const QByteArray& quitCommand)
+{
+    process->disconnect(); // the old owner is going away, nothing of it should hear from the process anymore
+    process->setParent(this);
+
+    if(process->state() == QProcess::NotRunning){
+        process->deleteLater();
+        return;
+    }
+
+    connect(process, &QProcess::finished, process, &QObject::deleteLater);
+    if(!quitCommand.isEmpty()) process->write(quitCommand);
+    process->closeWriteChannel();
+
+    QTimer::singleShot(terminateAfter, process, [process]{ process->terminate(); });
+    QTimer::singleShot(killAfter, process, [process]{ process->kill(); });
+}
+
+ProcessReaper::~ProcessReaper()
+{
+    // the window is already gone by now, this only holds up the process exiting and never for long
+    QElapsedTimer waited;
+    waited.start();
+
+#ifndef _WIN32
+    const QList<ChildWatcher*> watchers = findChildren<ChildWatcher*>(Qt::FindDirectChildrenOnly);
+    for(ChildWatcher* watcher : watchers){
+        while(!watcher->tryReap() && waited.elapsed() < shutdownWait) QThread::msleep(5);
+        if(!watcher->tryReap()) signalGroup(watcher->pid(), SIGKILL); // init reaps it once this process is gone
+    }
+#endif
+
+    const QList<QProcess*> processes = findChildren<QProcess*>(Qt::FindDirectChildrenOnly);
+    for(QProcess* process : processes){
+        const qint64 remaining = shutdownWait - waited.elapsed();
+        if(remaining <= 0 || !process->waitForFinished(int(remaining))) process->kill();
+    }
+}
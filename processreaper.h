@@ -0,0 +1,36 @@
+#ifndef PROCESSREAPER_H
+#define PROCESSREAPER_H
+
+#include <QObject>
+#include <QProcess>
+#ifndef _WIN32
+#include <sys/types.h>
+#endif
+
+// takes over processes whose owner is going away, so the gui never sits waiting for one to exit
+// an adopted process is asked to quit (hung up on, or sent "exit"), then escalated to SIGTERM and finally
+// SIGKILL on timers if its still there, and reaped when it goes. whatever is left when the application quits
+// gets a short bounded wait before being killed outright
+class ProcessReaper : public QObject
+{
+public:
+    static ProcessReaper* instance(); // lives as long as the application
+
+#ifndef _WIN32
+    // pid leads its own process group (a session, for a pty), the whole group gets the signals
+    void adopt(pid_t pid);
+#endif
+    // stdin is closed (after writing quitCommand if theres one), then terminate and kill follow on the same timers
+    void adopt(QProcess* process, const QByteArray& quitCommand = QByteArray());
+
+private:
+    explicit ProcessReaper(QObject* parent);
+    ~ProcessReaper(); // the application is quitting, waits at most shutdownWait for the stragglers
+
+private:
+    inline static constexpr int terminateAfter = 1000; // milliseconds after the first ask
+    inline static constexpr int killAfter = 3000;
+    inline static constexpr int shutdownWait = 300;
+};
+
+#endif // PROCESSREAPER_H
@@ -0,0 +1,407 @@
+#include "projectindexer.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <atomic>
+#include <utility>
+
+struct ProjectIndexer::Crawl
+{
+    QString root;
+    bool full = true; // the whole tree, otherwise a rescan of the directories that changed
+    QHash<QString, IndexedDirectory> previous; // what was indexed before, unchanged files keep its hashes
+    QSet<QString> known; // rescans dont go into directories already indexed, those have their own watch
+
+    std::atomic<bool> cancelled{false};
+    std::atomic<int> pending{0}; // tasks started and not finished yet
+
+    QMutex mutex;
+    QList<IndexedDirectory> results;
+};
+
+namespace {
+
+QByteArray hashContents(const QString& filePath, const std::atomic<bool>& cancelled)
+{
+    QFile file(filePath);
+    if(!file.open(QIODevice::ReadOnly)) return QByteArray();
+
+    QCryptographicHash hash(QCryptographicHash::Md5); // only compared against itself, like FileSaver::contentHash
+    while(!file.atEnd()){
+        if(cancelled.load(std::memory_order_relaxed)) return QByteArray();
+        const QByteArray chunk = file.read(1024 * 1024);
+        if(chunk.isEmpty()) break;
+        hash.addData(chunk);
+    }
+    return hash.result();
+}
+
+void diffFiles(const QList<IndexedFile>& before, const QList<IndexedFile>& after, QStringList* updated, QStringList* removed)
+{
+    QHash<QString, const IndexedFile*> old;
+    for(const IndexedFile& file : before) old.insert(file.path, &file);
+
+    for(const IndexedFile& file : after){
+        const IndexedFile* was = old.take(file.path);
+        if(was == nullptr || was->size != file.size || was->modified != file.modified || was->hash != file.hash) updated->append(file.path);
+    }
+    for(auto it = old.cbegin(); it != old.cend(); ++it) removed->append(it.key());
+}
+
+} // namespace
+
+ProjectIndexer::ProjectIndexer(QObject* parent) :
+    QObject(parent)
+{
+    cacheWriter.setMaxThreadCount(1);
+
+    rescanTimer.setSingleShot(true);
+    rescanTimer.setInterval(rescanDelay);
+    connect(&rescanTimer, &QTimer::timeout, this, &ProjectIndexer::rescan);
+
+    saveTimer.setSingleShot(true);
+    saveTimer.setInterval(saveDelay);
+    connect(&saveTimer, &QTimer::timeout, this, &ProjectIndexer::saveCache);
+
+    connect(&watcher, &QFileSystemWatcher::directoryChanged, this, &ProjectIndexer::directoryChanged);
+}
+
+ProjectIndexer::~ProjectIndexer()
+{
+    close();
+    pool.waitForDone(); // cancelled tasks stop at the next file, or the next chunk of a file being hashed
+    cacheWriter.waitForDone();
+}
+
+void ProjectIndexer::open(const QString& path)
+{
+    close();
+    rootPath = QDir(path).absolutePath();
+
+    const std::shared_ptr<Crawl> crawl = std::make_shared<Crawl>();
+    crawl->root = rootPath;
+    crawl->pending = 1;
+    activeCrawl = crawl;
+
+    pool.start([this, crawl]{
+        if(!crawl->cancelled.load(std::memory_order_relaxed)){
+            // the cached index goes to the gui straight away, and then gets checked against the disk
+            crawl->previous = readCache(crawl->root);
+            if(!crawl->previous.isEmpty()){
+                QMetaObject::invokeMethod(this, [this, crawl, cached = crawl->previous]{
+                    cacheLoaded(crawl, cached);
+                }, Qt::QueuedConnection);
+            }
+        }
+        scan(crawl, QString());
+    });
+}
+
+void ProjectIndexer::close()
+{
+    if(activeCrawl != nullptr) activeCrawl->cancelled = true;
+    activeCrawl.reset();
+
+    if(unsaved) saveCache();
+
+    const QStringList watched = watcher.directories();
+    if(!watched.isEmpty()) watcher.removePaths(watched);
+
+    rescanTimer.stop();
+    changedDirectories.clear();
+    directories.clear();
+    ready = false;
+    rootPath.clear();
+}
+
+QList<IndexedFile> ProjectIndexer::files() const
+{
+    QList<IndexedFile> all;
+    all.reserve(fileCount());
+    for(const IndexedDirectory& directory : directories) all.append(directory.files);
+    return all;
+}
+
+qsizetype ProjectIndexer::fileCount() const
+{
+    qsizetype count = 0;
+    for(const IndexedDirectory& directory : directories) count += directory.files.size();
+    return count;
+}
+
+QString ProjectIndexer::cacheDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/index";
+}
+
+QString ProjectIndexer::cachePath(const QString& rootPath)
+{
+    // one cache per folder, named after a hash of its path like the edit journals
+    const QByteArray name = QCryptographicHash::hash(rootPath.toUtf8(), QCryptographicHash::Md5).toHex();
+    return cacheDirectory() + "/" + QString::fromLatin1(name) + ".index";
+}
+
+void ProjectIndexer::scan(const std::shared_ptr<Crawl>& crawl, const QString& relativePath)
+{
+    if(crawl->cancelled.load(std::memory_order_relaxed)){
+        finishTask(crawl);
+        return;
+    }
+
+    IndexedDirectory scanned;
+    scanned.path = relativePath;
+    const QString directoryPath = relativePath.isEmpty() ? crawl->root : crawl->root + "/" + relativePath;
+    scanned.exists = QFileInfo(directoryPath).isDir();
+
+    if(scanned.exists){
+        QHash<QString, const IndexedFile*> previous;
+        const auto before = std::as_const(crawl->previous).constFind(relativePath);
+        if(before != crawl->previous.cend()){
+            for(const IndexedFile& file : before->files) previous.insert(file.path, &file);
+        }
+
+        // without QDir::Hidden, dot files and directories (.git and the like) are left out
+        QDirIterator entries(directoryPath, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+        while(entries.hasNext() && !crawl->cancelled.load(std::memory_order_relaxed)){
+            entries.next();
+            const QFileInfo info = entries.fileInfo();
+            const QString path = relativePath.isEmpty() ? info.fileName() : relativePath + "/" + info.fileName();
+
+            if(info.isDir()){
+                if(skippedDirectories.contains(info.fileName())) continue;
+                scanned.subdirectories.append(path);
+                if(!crawl->known.contains(path)){
+                    // its own task, whichever thread is free next picks it up
+                    crawl->pending.fetch_add(1, std::memory_order_relaxed);
+                    pool.start([this, crawl, path]{ scan(crawl, path); });
+                }
+                continue;
+            }
+
+            IndexedFile file;
+            file.path = path;
+            file.size = info.size();
+            file.modified = info.lastModified().toMSecsSinceEpoch();
+
+            const IndexedFile* was = previous.value(path);
+            if(was != nullptr && was->size == file.size && was->modified == file.modified) file.hash = was->hash;
+            else if(file.size <= maxHashedSize) file.hash = hashContents(info.filePath(), crawl->cancelled);
+
+            scanned.files.append(std::move(file));
+        }
+    }
+
+    {
+        QMutexLocker lock(&crawl->mutex);
+        crawl->results.append(std::move(scanned));
+    }
+    finishTask(crawl);
+}
+
+void ProjectIndexer::finishTask(const std::shared_ptr<Crawl>& crawl)
+{
+    if(crawl->pending.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+
+    QMetaObject::invokeMethod(this, [this, crawl]{ crawlFinished(crawl); }, Qt::QueuedConnection);
+}
+
+void ProjectIndexer::cacheLoaded(const std::shared_ptr<Crawl>& crawl, const QHash<QString, IndexedDirectory>& cached)
+{
+    if(crawl != activeCrawl) return; // closed, or another folder was opened since
+
+    directories = cached;
+    ready = true;
+    watch(directories.keys()); // changes made while the crawl checks the cache get rescanned after it
+    emit indexReady();
+}
+
+void ProjectIndexer::crawlFinished(const std::shared_ptr<Crawl>& crawl)
+{
+    if(crawl != activeCrawl) return;
+    activeCrawl.reset();
+
+    QStringList updated;
+    QStringList removed;
+
+    if(crawl->full){
+        QHash<QString, IndexedDirectory> scanned;
+        scanned.reserve(crawl->results.size());
+        for(IndexedDirectory& directory : crawl->results){
+            if(directory.exists) scanned.insert(directory.path, std::move(directory));
+        }
+
+        if(ready){
+            // the cached index is already out there, only whats different since gets sent
+            for(auto it = directories.cbegin(); it != directories.cend(); ++it){
+                const auto now = scanned.constFind(it.key());
+                diffFiles(it->files, now != scanned.cend() ? now->files : QList<IndexedFile>(), &updated, &removed);
+            }
+            for(auto it = scanned.cbegin(); it != scanned.cend(); ++it){
+                if(!directories.contains(it.key())) diffFiles(QList<IndexedFile>(), it->files, &updated, &removed);
+            }
+        }
+
+        directories = std::move(scanned);
+        watch(directories.keys());
+
+        if(!ready){
+            ready = true;
+            emit indexReady();
+        }
+        else if(!updated.isEmpty() || !removed.isEmpty()){
+            emit filesUpdated(updated, removed);
+        }
+    }
+    else{
+        QStringList added;
+        for(IndexedDirectory& directory : crawl->results){
+            if(!directory.exists){
+                removeTree(directory.path, &removed);
+                continue;
+            }
+
+            const auto before = directories.constFind(directory.path);
+            if(before == directories.cend()){
+                added.append(directory.path);
+                diffFiles(QList<IndexedFile>(), directory.files, &updated, &removed);
+            }
+            else{
+                diffFiles(before->files, directory.files, &updated, &removed);
+                const QStringList subdirectories = before->subdirectories;
+                for(const QString& subdirectory : subdirectories){
+                    if(!directory.subdirectories.contains(subdirectory)) removeTree(subdirectory, &removed);
+                }
+            }
+            directories.insert(directory.path, std::move(directory));
+        }
+        watch(added);
+
+        if(!updated.isEmpty() || !removed.isEmpty()) emit filesUpdated(updated, removed);
+    }
+
+    unsaved = true;
+    saveTimer.start();
+
+    if(!changedDirectories.isEmpty()) rescanTimer.start(); // changed while this was crawling
+}
+
+void ProjectIndexer::directoryChanged(const QString& absolutePath)
+{
+    QString relativePath = QDir(rootPath).relativeFilePath(absolutePath);
+    if(relativePath == ".") relativePath.clear();
+    if(relativePath.startsWith("..")) return;
+
+    changedDirectories.insert(relativePath);
+    rescanTimer.start(); // restarts, a burst of changes (a checkout, a build) gets rescanned once
+}
+
+void ProjectIndexer::rescan()
+{
+    if(activeCrawl != nullptr || changedDirectories.isEmpty()) return; // crawlFinished starts it again
+
+    const std::shared_ptr<Crawl> crawl = std::make_shared<Crawl>();
+    crawl->root = rootPath;
+    crawl->full = false;
+    crawl->previous = directories;
+    for(auto it = directories.cbegin(); it != directories.cend(); ++it) crawl->known.insert(it.key());
+    activeCrawl = crawl;
+
+    const QSet<QString> changed = std::exchange(changedDirectories, QSet<QString>());
+    crawl->pending = int(changed.size());
+    for(const QString& relativePath : changed) pool.start([this, crawl, relativePath]{ scan(crawl, relativePath); });
+}
+
+void ProjectIndexer::removeTree(const QString& relativePath, QStringList* removed)
+{
+    if(!directories.contains(relativePath)) return;
+    const IndexedDirectory directory = directories.take(relativePath);
+
+    for(const IndexedFile& file : directory.files) removed->append(file.path);
+    for(const QString& subdirectory : directory.subdirectories) removeTree(subdirectory, removed);
+
+    watcher.removePath(absolutePath(relativePath)); // the watch goes with the directory anyway, this is for renames
+}
+
+void ProjectIndexer::watch(const QStringList& relativePaths)
+{
+    const QStringList watchedList = watcher.directories();
+    const QSet<QString> watched(watchedList.cbegin(), watchedList.cend());
+
+    QStringList paths;
+    for(const QString& relativePath : relativePaths){
+        if(watched.size() + paths.size() >= maxWatchedDirectories) break;
+        const QString path = absolutePath(relativePath);
+        if(!watched.contains(path)) paths.append(path);
+    }
+    if(!paths.isEmpty()) watcher.addPaths(paths);
+}
+
+void ProjectIndexer::saveCache()
+{
+    saveTimer.stop();
+    unsaved = false;
+    if(rootPath.isEmpty() || !ready) return;
+
+    // the hash is implicitly shared, the copy costs nothing until the index changes again
+    cacheWriter.start([root = rootPath, snapshot = directories]{ writeCache(root, snapshot); });
+}
+
+QString ProjectIndexer::absolutePath(const QString& relativePath) const
+{
+    return relativePath.isEmpty() ? rootPath : rootPath + "/" + relativePath;
+}
+
+QHash<QString, IndexedDirectory> ProjectIndexer::readCache(const QString& rootPath)
+{
+    QFile file(cachePath(rootPath));
+    if(!file.open(QIODevice::ReadOnly)) return {};
+
+    QDataStream in(&file);
+    in.setVersion(streamVersion);
+
+    quint32 fileMagic = 0;
+    quint16 fileVersion = 0;
+    QString cachedRoot;
+    quint32 directoryCount = 0;
+    in >> fileMagic >> fileVersion >> cachedRoot >> directoryCount;
+    if(in.status() != QDataStream::Ok || fileMagic != magic || fileVersion != version || cachedRoot != rootPath) return {};
+
+    QHash<QString, IndexedDirectory> cached;
+    for(quint32 i = 0; i < directoryCount; ++i){
+        IndexedDirectory directory;
+        quint32 fileCount = 0;
+        in >> directory.path >> directory.subdirectories >> fileCount;
+        if(in.status() != QDataStream::Ok) return {};
+
+        for(quint32 j = 0; j < fileCount; ++j){
+            IndexedFile indexed;
+            in >> indexed.path >> indexed.size >> indexed.modified >> indexed.hash;
+            if(in.status() != QDataStream::Ok) return {}; // cut short or corrupt, the crawl builds it from scratch
+            directory.files.append(std::move(indexed));
+        }
+        cached.insert(directory.path, std::move(directory));
+    }
+    return cached;
+}
+
+void ProjectIndexer::writeCache(const QString& rootPath, const QHash<QString, IndexedDirectory>& directories)
+{
+    QDir().mkpath(cacheDirectory());
+
+    QSaveFile file(cachePath(rootPath)); // a crash halfway through leaves the previous cache
+    if(!file.open(QIODevice::WriteOnly)) return;
+
+    QDataStream out(&file);
+    out.setVersion(streamVersion);
+    out << magic << version << rootPath << quint32(directories.size());
+    for(const IndexedDirectory& directory : directories){
+        out << directory.path << directory.subdirectories << quint32(directory.files.size());
+        for(const IndexedFile& indexed : directory.files) out << indexed.path << indexed.size << indexed.modified << indexed.hash;
+    }
+    file.commit();
+}
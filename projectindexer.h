@@ -0,0 +1,111 @@
+#ifndef PROJECTINDEXER_H
+#define PROJECTINDEXER_H
+
+#include <QObject>
+#include <QDataStream>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+#include <memory>
+
+struct IndexedFile
+{
+    QString path; // relative to the projects root, with / separators
+    qint64 size = 0;
+    qint64 modified = 0; // milliseconds since epoch
+    QByteArray hash; // md5 of the contents, empty for files too big to bother hashing
+};
+
+struct IndexedDirectory
+{
+    QString path; // relative to the root, the root itself is ""
+    QList<IndexedFile> files;
+    QStringList subdirectories; // relative paths too
+    bool exists = true; // false for a rescanned directory thats been deleted
+};
+
+// keeps an index of every file under an opened folder: path, size, modification time and a hash of the contents
+// the tree is crawled on a thread pool, one task per directory with each subdirectory handed back to the pool as its
+// own task, so the threads pick up whatever is left and a deep branch doesnt hold up the rest. unchanged files
+// (same size and modification time) keep their hash from the last crawl, so only new or changed files get read.
+// the index is cached on disk per folder, reopening a folder shows the cached index right away and then checks it
+// against the disk in the background. afterwards directories are watched, a change rescans just that directory
+class ProjectIndexer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ProjectIndexer(QObject* parent);
+    ~ProjectIndexer(); // cancels a crawl thats still going, and writes out the cache if it changed
+
+    void open(const QString& rootPath);
+    void close();
+
+    inline QString root() const
+    {
+        return rootPath;
+    }
+    inline bool isReady() const // false until the cache is loaded or the first crawl finishes
+    {
+        return ready;
+    }
+    QList<IndexedFile> files() const;
+    qsizetype fileCount() const;
+
+    static QString cacheDirectory();
+    static QString cachePath(const QString& rootPath);
+
+    // never indexed, hidden ones are skipped too
+    inline static const QStringList skippedDirectories{"__pycache__", "node_modules"};
+
+public: // the cache format
+    inline static constexpr quint32 magic = 0x54454931; // "TEI1"
+    inline static constexpr quint16 version = 1;
+    inline static constexpr QDataStream::Version streamVersion = QDataStream::Qt_6_0;
+
+signals:
+    void indexReady(); // the whole index was replaced, from the cache or a finished first crawl
+    void filesUpdated(const QStringList& updated, const QStringList& removed); // relative paths, updated is new or changed
+
+private:
+    struct Crawl;
+
+    void scan(const std::shared_ptr<Crawl>& crawl, const QString& relativePath); // on the pool
+    void finishTask(const std::shared_ptr<Crawl>& crawl); // on the pool, the last task to finish reports the crawl done
+    void cacheLoaded(const std::shared_ptr<Crawl>& crawl, const QHash<QString, IndexedDirectory>& cached);
+    void crawlFinished(const std::shared_ptr<Crawl>& crawl);
+    void directoryChanged(const QString& absolutePath);
+    void rescan(); // the directories that changed since the last rescan
+    void removeTree(const QString& relativePath, QStringList* removed);
+    void watch(const QStringList& relativePaths);
+    void saveCache();
+
+    QString absolutePath(const QString& relativePath) const;
+
+    static QHash<QString, IndexedDirectory> readCache(const QString& rootPath);
+    static void writeCache(const QString& rootPath, const QHash<QString, IndexedDirectory>& directories);
+
+private:
+    inline static constexpr qint64 maxHashedSize = 8 * 1024 * 1024; // bytes, bigger files arent worth reading
+    inline static constexpr int maxWatchedDirectories = 8192; // past this changes only show up on the next open
+    inline static constexpr int rescanDelay = 200; // milliseconds changes are collected before rescanning
+    inline static constexpr int saveDelay = 2000;
+
+    QString rootPath;
+    bool ready = false;
+    QHash<QString, IndexedDirectory> directories; // by relative path
+
+    QThreadPool pool;
+    QThreadPool cacheWriter; // one thread, so saves land in the order they were made
+    std::shared_ptr<Crawl> activeCrawl; // at most one at a time, rescans wait for it to finish
+
+    QFileSystemWatcher watcher;
+    QSet<QString> changedDirectories;
+    QTimer rescanTimer;
+    QTimer saveTimer;
+    bool unsaved = false;
+};
+
+#endif // PROJECTINDEXER_H
@@ -0,0 +1,357 @@
+#include "ptyprocess.h"
+#include "processreaper.h"
+#include <utility>
+
+#ifdef _WIN32
+
+PtyProcess::PtyProcess(QObject* parent) :
+    QObject(parent)
+{
+}
+
+PtyProcess::~PtyProcess()
+{
+    stop();
+}
+
+bool PtyProcess::start(const QString& program, const QString& workingDirectory, int columns, int rows)
+{
+    Q_UNUSED(columns);
+    Q_UNUSED(rows);
+
+    if(isRunning()) return true;
+
+    process = new QProcess(this);
+    process->setProcessChannelMode(QProcess::MergedChannels);
+    process->setWorkingDirectory(workingDirectory);
+    connect(process, &QProcess::readyRead, this, &PtyProcess::readAvailable);
+    connect(process, &QProcess::started, this, &PtyProcess::started);
+    connect(process, &QProcess::errorOccurred, this, [this](QProcess::ProcessError processError){
+        if(processError != QProcess::FailedToStart) return;
+        error = process->errorString();
+        std::exchange(process, nullptr)->deleteLater();
+        emit failedToStart(error);
+    });
+    connect(process, &QProcess::finished, this, [this](int exitCode){
+        readAvailable();
+        std::exchange(process, nullptr)->deleteLater();
+        emit finished(exitCode);
+    });
+
+    error.clear();
+    process->start(program, QStringList());
+    return true;
+}
+
+bool PtyProcess::isRunning() const
+{
+    return process != nullptr;
+}
+
+void PtyProcess::write(const QByteArray& input)
+{
+    if(process == nullptr) return;
+
+    // theres no terminal driver to echo and edit lines, so a minimal one lives here
+    QByteArray echo;
+    for(qsizetype i = 0; i < input.size(); ++i){
+        const char c = input.at(i);
+        if(c == '\r'){
+            process->write(std::exchange(lineBuffer, QByteArray()) + "\r\n");
+            echo.append("\r\n");
+        }
+        else if(c == '\x7f' || c == '\b'){
+            if(lineBuffer.isEmpty()) continue;
+            // drop the whole utf-8 character, not just its last byte
+            while(!lineBuffer.isEmpty() && (lineBuffer.back() & 0xC0) == 0x80) lineBuffer.chop(1);
+            lineBuffer.chop(1);
+            echo.append("\b \b");
+        }
+        else if(c == '\x1b'){
+            break; // arrow keys and the like, nothing to do with them on a pipe
+        }
+        else if(uchar(c) >= 0x20 || c == '\t' || c == '\n'){
+            if(c == '\n'){
+                process->write(std::exchange(lineBuffer, QByteArray()) + "\r\n");
+                echo.append("\r\n");
+                continue;
+            }
+            lineBuffer.append(c);
+            echo.append(c);
+        }
+    }
+    if(!echo.isEmpty()) emit outputReady(echo);
+}
+
+void PtyProcess::resize(int columns, int rows)
+{
+    Q_UNUSED(columns);
+    Q_UNUSED(rows);
+}
+
+void PtyProcess::readAvailable()
+{
+    if(process == nullptr) return;
+    const QByteArray output = process->readAll();
+    if(!output.isEmpty()) emit outputReady(output);
+}
+
+void PtyProcess::writePending()
+{
+}
+
+void PtyProcess::stop()
+{
+    if(process == nullptr) return;
+    ProcessReaper::instance()->adopt(std::exchange(process, nullptr), "exit\r\n");
+}
+
+#else
+
+#include "childwatcher.h"
+#include <QFile>
+#include <QProcessEnvironment>
+#include <QSocketNotifier>
+#include <vector>
+#include <cerrno>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+PtyProcess::PtyProcess(QObject* parent) :
+    QObject(parent)
+{
+}
+
+PtyProcess::~PtyProcess()
+{
+    stop();
+}
+
+bool PtyProcess::start(const QString& program, const QString& workingDirectory, int columns, int rows)
+{
+    if(isRunning()) return true;
+
+    masterFd = ::posix_openpt(O_RDWR | O_NOCTTY);
+    if(masterFd < 0 || ::grantpt(masterFd) != 0 || ::unlockpt(masterFd) != 0){
+        error = qt_error_string(errno);
+        if(masterFd >= 0) ::close(masterFd);
+        masterFd = -1;
+        return false;
+    }
+    ::fcntl(masterFd, F_SETFD, FD_CLOEXEC);
+
+    // everything the child needs is built before forking, between fork and exec only async signal safe calls are allowed
+    const QByteArray slavePath(::ptsname(masterFd));
+    const QByteArray programPath = QFile::encodeName(program);
+    const QByteArray directory = QFile::encodeName(workingDirectory);
+
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert("TERM", "xterm-256color");
+    environment.insert("COLORTERM", "truecolor");
+    QList<QByteArray> environmentStrings;
+    for(const QString& entry : environment.toStringList()) environmentStrings.append(entry.toLocal8Bit());
+
+    std::vector<char*> envp;
+    for(QByteArray& entry : environmentStrings) envp.push_back(entry.data());
+    envp.push_back(nullptr);
+    char* argv[] = {const_cast<char*>(programPath.constData()), nullptr};
+
+    struct winsize size = {};
+    size.ws_row = static_cast<unsigned short>(rows);
+    size.ws_col = static_cast<unsigned short>(columns);
+
+    // both ends close on exec, so a successful exec reads as eof in the parent
+    int execPipe[2];
+    if(::pipe(execPipe) != 0){
+        error = qt_error_string(errno);
+        ::close(masterFd);
+        masterFd = -1;
+        return false;
+    }
+    ::fcntl(execPipe[0], F_SETFD, FD_CLOEXEC);
+    ::fcntl(execPipe[1], F_SETFD, FD_CLOEXEC);
+
+    childPid = ::fork();
+    if(childPid < 0){
+        error = qt_error_string(errno);
+        ::close(execPipe[0]);
+        ::close(execPipe[1]);
+        ::close(masterFd);
+        masterFd = -1;
+        return false;
+    }
+
+    if(childPid == 0){
+        const auto fail = [&execPipe]{
+            const int execError = errno;
+            (void)::write(execPipe[1], &execError, sizeof(execError));
+            ::_exit(127);
+        };
+
+        // a new session, with the pty as its controlling terminal
+        ::setsid();
+        const int slave = ::open(slavePath.constData(), O_RDWR);
+        if(slave < 0) fail();
+        ::ioctl(slave, TIOCSCTTY, 0);
+        ::ioctl(slave, TIOCSWINSZ, &size);
+        ::dup2(slave, STDIN_FILENO);
+        ::dup2(slave, STDOUT_FILENO);
+        ::dup2(slave, STDERR_FILENO);
+        if(slave > STDERR_FILENO) ::close(slave);
+
+        // dont pass on anything the gui blocked or ignored
+        sigset_t none;
+        ::sigemptyset(&none);
+        ::sigprocmask(SIG_SETMASK, &none, nullptr);
+        ::signal(SIGPIPE, SIG_DFL);
+
+        // if the directory is gone it just starts wherever the editor is
+        if(!directory.isEmpty()) (void)::chdir(directory.constData());
+        ::execve(argv[0], argv, envp.data());
+        fail();
+    }
+
+    ::close(execPipe[1]);
+    execErrorFd = execPipe[0];
+    execNotifier = new QSocketNotifier(execErrorFd, QSocketNotifier::Read, this);
+    connect(execNotifier, &QSocketNotifier::activated, this, &PtyProcess::readExecResult);
+
+    childWatcher = new ChildWatcher(childPid, this);
+    connect(childWatcher, &ChildWatcher::exited, this, &PtyProcess::childExited);
+
+    ::fcntl(masterFd, F_SETFL, ::fcntl(masterFd, F_GETFL) | O_NONBLOCK);
+
+    readNotifier = new QSocketNotifier(masterFd, QSocketNotifier::Read, this);
+    connect(readNotifier, &QSocketNotifier::activated, this, &PtyProcess::readAvailable);
+
+    writeNotifier = new QSocketNotifier(masterFd, QSocketNotifier::Write, this);
+    writeNotifier->setEnabled(false);
+    connect(writeNotifier, &QSocketNotifier::activated, this, &PtyProcess::writePending);
+
+    error.clear();
+    return true;
+}
+
+bool PtyProcess::isRunning() const
+{
+    return childPid > 0;
+}
+
+void PtyProcess::write(const QByteArray& input)
+{
+    if(masterFd < 0) return;
+    unwritten.append(input);
+    writePending();
+}
+
+void PtyProcess::writePending()
+{
+    while(!unwritten.isEmpty()){
+        const ssize_t written = ::write(masterFd, unwritten.constData(), size_t(unwritten.size()));
+        if(written > 0){
+            unwritten.remove(0, written);
+            continue;
+        }
+        if(written < 0 && errno == EINTR) continue;
+        break; // the terminals input queue is full, the notifier says when theres room again
+    }
+    writeNotifier->setEnabled(!unwritten.isEmpty());
+}
+
+void PtyProcess::resize(int columns, int rows)
+{
+    if(masterFd < 0) return;
+
+    struct winsize size = {};
+    size.ws_row = static_cast<unsigned short>(rows);
+    size.ws_col = static_cast<unsigned short>(columns);
+    ::ioctl(masterFd, TIOCSWINSZ, &size);
+}
+
+void PtyProcess::readAvailable()
+{
+    QByteArray output;
+    char chunk[64 * 1024];
+    bool hungUp = false;
+
+    while(output.size() < maxReadPerWakeup){
+        const ssize_t count = ::read(masterFd, chunk, sizeof(chunk));
+        if(count > 0){
+            output.append(chunk, count);
+            continue;
+        }
+        if(count < 0 && errno == EINTR) continue;
+        if(count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+
+        // EOF or EIO, every process on the terminal has closed it
+        hungUp = true;
+        break;
+    }
+
+    if(!output.isEmpty()) emit outputReady(output);
+    if(hungUp) readNotifier->setEnabled(false); // the child watcher says when the shell itself is gone
+}
+
+void PtyProcess::readExecResult()
+{
+    int execError = 0;
+    ssize_t count;
+    do{
+        count = ::read(execErrorFd, &execError, sizeof(execError));
+    } while(count < 0 && errno == EINTR);
+
+    delete execNotifier;
+    execNotifier = nullptr;
+    ::close(execErrorFd);
+    execErrorFd = -1;
+
+    if(count == ssize_t(sizeof(execError))){
+        error = qt_error_string(execError);
+        emit failedToStart(error);
+    }
+    else emit started();
+}
+
+void PtyProcess::childExited(int exitCode)
+{
+    // either can come first, whatever the child said before it went still gets through
+    if(execNotifier != nullptr) readExecResult();
+    if(readNotifier != nullptr && readNotifier->isEnabled()) readAvailable();
+
+    closeTerminal();
+    childWatcher->deleteLater();
+    childWatcher = nullptr;
+    childPid = -1;
+
+    emit finished(exitCode);
+}
+
+void PtyProcess::closeTerminal()
+{
+    delete execNotifier;
+    delete readNotifier;
+    delete writeNotifier;
+    execNotifier = readNotifier = writeNotifier = nullptr;
+    if(execErrorFd >= 0) ::close(execErrorFd);
+    if(masterFd >= 0) ::close(masterFd);
+    execErrorFd = masterFd = -1;
+    unwritten.clear();
+}
+
+void PtyProcess::stop()
+{
+    if(childPid <= 0) return;
+
+    // closing the master hangs up the terminal, whatever doesnt take the hint is the reapers problem now
+    closeTerminal();
+    delete childWatcher;
+    childWatcher = nullptr;
+    ProcessReaper::instance()->adopt(childPid);
+    childPid = -1;
+}
+
+#endif
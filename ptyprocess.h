@@ -0,0 +1,74 @@
+#ifndef PTYPROCESS_H
+#define PTYPROCESS_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QString>
+
+#ifdef _WIN32
+#include <QProcess>
+#else
+#include <sys/types.h>
+class QSocketNotifier;
+class ChildWatcher;
+#endif
+
+// runs a program (the shell) on a pseudo terminal, so it sees a real tty: line editing and echo come from the
+// kernels terminal driver, programs line buffer instead of block buffering, and colors get turned on.
+// the master side is non blocking and read through a QSocketNotifier, so output shows up the moment its written.
+// windows has no ptys in the posix sense, there it falls back to pipes with a local echo so typing still shows
+class PtyProcess : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PtyProcess(QObject* parent = nullptr);
+    ~PtyProcess(); // hands the shell to the ProcessReaper, never waits for it
+
+    // false only if the terminal itself couldnt be set up, a program that fails to run shows up in failedToStart
+    bool start(const QString& program, const QString& workingDirectory, int columns, int rows);
+    bool isRunning() const;
+    void write(const QByteArray& input);
+    void resize(int columns, int rows); // the kernel sends SIGWINCH to whatever is in the foreground
+
+    inline QString errorString() const
+    {
+        return error;
+    }
+
+signals:
+    void started();
+    void failedToStart(const QString& message); // finished still follows on unix, the forked child exits with 127
+    void outputReady(const QByteArray& output);
+    void finished(int exitCode);
+
+private:
+    void readAvailable();
+    void writePending();
+    void stop();
+#ifndef _WIN32
+    void readExecResult(); // the child writes errno down the pipe if exec fails, otherwise it just closes on exec
+    void childExited(int exitCode);
+    void closeTerminal();
+#endif
+
+private:
+    QString error;
+
+#ifdef _WIN32
+    QProcess* process = nullptr; // goes to the ProcessReaper on stop, so its never waited on here
+    QByteArray lineBuffer; // what was typed since the last return, the pipe only gets whole lines
+#else
+    inline static constexpr qsizetype maxReadPerWakeup = 1024 * 1024; // lets the event loop breathe under a flood
+
+    int masterFd = -1;
+    pid_t childPid = -1;
+    int execErrorFd = -1;
+    ChildWatcher* childWatcher = nullptr;
+    QSocketNotifier* execNotifier = nullptr;
+    QSocketNotifier* readNotifier = nullptr;
+    QSocketNotifier* writeNotifier = nullptr;
+    QByteArray unwritten; // input the terminal couldnt take yet
+#endif
+};
+
+#endif // PTYPROCESS_H
@@ -0,0 +1,172 @@
+#include "pythonlexer.h"
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+// sorted (by utf 16 code unit) so it can be binary searched
+constexpr QStringView keywords[] = {
+    u"False", u"None", u"True", u"and", u"as", u"assert", u"async", u"await", u"break", u"class",
+    u"continue", u"def", u"del", u"elif", u"else", u"except", u"finally", u"for", u"from", u"global",
+    u"if", u"import", u"in", u"is", u"lambda", u"nonlocal", u"not", u"or", u"pass", u"raise",
+    u"return", u"try", u"while", u"with", u"yield"
+};
+
+bool isKeyword(QStringView word)
+{
+    return std::binary_search(std::begin(keywords), std::end(keywords), word);
+}
+
+// r"", b"", f"", u"" and the two letter combinations of r with b or f
+bool isStringPrefix(QStringView word)
+{
+    if(word.size() > 2) return false;
+
+    bool raw = false, other = false;
+    for(const QChar c : word){
+        const char16_t lower = c.toLower().unicode();
+        if(lower == u'r' && !raw) raw = true;
+        else if((lower == u'b' || lower == u'f' || (lower == u'u' && word.size() == 1)) && !other) other = true;
+        else return false;
+    }
+    return true;
+}
+
+inline bool isIdentifierStart(QChar c)
+{
+    return c.isLetter() || c == u'_';
+}
+
+inline bool isIdentifierPart(QChar c)
+{
+    return c.isLetterOrNumber() || c == u'_';
+}
+
+struct StringScan
+{
+    int end; // one past the closing quote, or the line length if it never closed
+    bool closed;
+    bool escapedNewline; // the line ended on a backslash inside the string
+};
+
+// scans the body of a string starting at i, up to and including its closing quote
+StringScan scanString(QStringView line, int i, QChar quote, bool triple)
+{
+    const int length = static_cast<int>(line.size());
+    while(i < length){
+        const QChar c = line[i];
+        if(c == u'\\'){
+            if(i + 1 == length) return {length, false, true};
+            i += 2; // skips whatever is escaped, including a quote
+            continue;
+        }
+        if(c == quote){
+            if(!triple) return {i + 1, true, false};
+            if(i + 2 < length && line[i + 1] == quote && line[i + 2] == quote) return {i + 3, true, false};
+        }
+        i++;
+    }
+    return {length, false, false};
+}
+
+} // namespace
+
+int PythonLexer::tokenizeLine(QStringView line, int previousState, QVector<TokenRun>& runs)
+{
+    const int length = static_cast<int>(line.size());
+    int openKind = openString(previousState);
+
+    int i = 0;
+
+    // picks up a string the previous line left open
+    if(openKind != NoString){
+        const bool triple = openKind == TripleDouble || openKind == TripleSingle;
+        const QChar quote = (openKind == TripleDouble || openKind == ContinuedDouble) ? u'"' : u'\'';
+
+        const StringScan scan = scanString(line, 0, quote, triple);
+        if(scan.end > 0) runs.append({0, scan.end, PythonToken::String});
+
+        if(!scan.closed){
+            if(triple) return openKind;
+            if(scan.escapedNewline) return openKind;
+            return NoString; // an unterminated single line string just ends with the line
+        }
+        openKind = NoString;
+        i = scan.end;
+    }
+
+    // set after def/class so the next identifier gets the function/class color
+    PythonToken pendingName = PythonToken::Keyword;
+    bool namePending = false;
+
+    auto startString = [&](int start, int quoteIndex) -> int {
+        const QChar quote = line[quoteIndex];
+        const bool triple = quoteIndex + 2 < length && line[quoteIndex + 1] == quote && line[quoteIndex + 2] == quote;
+
+        const StringScan scan = scanString(line, quoteIndex + (triple ? 3 : 1), quote, triple);
+        runs.append({start, scan.end - start, PythonToken::String});
+
+        if(!scan.closed){
+            if(triple) openKind = quote == u'"' ? TripleDouble : TripleSingle;
+            else if(scan.escapedNewline) openKind = quote == u'"' ? ContinuedDouble : ContinuedSingle;
+        }
+        return scan.end;
+    };
+
+    while(i < length){
+        const QChar c = line[i];
+
+        if(c == u'#'){
+            runs.append({i, length - i, PythonToken::Comment});
+            break;
+        }
+
+        if(c == u'"' || c == u'\''){
+            namePending = false;
+            i = startString(i, i);
+            continue;
+        }
+
+        if(isIdentifierStart(c)){
+            int end = i + 1;
+            while(end < length && isIdentifierPart(line[end])) end++;
+            const QStringView word = line.mid(i, end - i);
+
+            if(end < length && (line[end] == u'"' || line[end] == u'\'') && isStringPrefix(word)){
+                namePending = false;
+                i = startString(i, end);
+                continue;
+            }
+
+            if(namePending){
+                runs.append({i, end - i, pendingName});
+                namePending = false;
+            }
+            else if(isKeyword(word)){
+                runs.append({i, end - i, PythonToken::Keyword});
+                if(word == u"def"){
+                    pendingName = PythonToken::Function;
+                    namePending = true;
+                }
+                else if(word == u"class"){
+                    pendingName = PythonToken::Class;
+                    namePending = true;
+                }
+            }
+            i = end;
+            continue;
+        }
+
+        if(c.isDigit()){
+            // skips the whole literal so things like 1e5 or 0xff dont get read as identifiers
+            while(i < length && (isIdentifierPart(line[i]) || line[i] == u'.')) i++;
+            namePending = false;
+            continue;
+        }
+
+        if(!c.isSpace()) namePending = false;
+        i++;
+    }
+
+    return openKind;
+}
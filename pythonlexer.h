@@ -0,0 +1,52 @@
+#ifndef PYTHONLEXER_H
+#define PYTHONLEXER_H
+
+#include <QStringView>
+#include <QVector>
+
+// the kinds of text the highlighter gives a color to
+enum class PythonToken : quint8 {
+    Keyword,
+    Function, // the name after def
+    Class, // the name after class
+    String,
+    Comment
+};
+
+struct TokenRun
+{
+    int start;
+    int length;
+    PythonToken token;
+};
+
+// single pass python tokenizer working one line at a time
+// everything a line needs from the lines above it is packed into an int state, which is what
+// QSyntaxHighlighter stores per block, so an edit only re-lexes lines until the state stops changing
+// doesnt touch any gui objects, so it can run on any thread
+class PythonLexer
+{
+public:
+    PythonLexer() = delete;
+
+    // lexes one line given the state the previous line ended in (-1 for none), appends the colored runs
+    // and returns the state this line ends in
+    static int tokenizeLine(QStringView line, int previousState, QVector<TokenRun>& runs);
+
+    // the state is only the kind of string left open. nothing else a line carries over changes any colors, and
+    // anything more in it (like bracket depth) would make one edit change the state of every line after it
+    static inline int openString(int state)
+    {
+        return state < 0 ? NoString : state;
+    }
+
+    enum OpenString {
+        NoString = 0,
+        TripleDouble, // """ ... still going
+        TripleSingle, // ''' ... still going
+        ContinuedDouble, // "...\ continued onto the next line
+        ContinuedSingle // '...\ continued onto the next line
+    };
+};
+
+#endif // PYTHONLEXER_H
@@ -0,0 +1,156 @@
+#include "quickopen.h"
+#include "projectindexer.h"
+#include <QCoreApplication>
+#include <QKeyEvent>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QVBoxLayout>
+
+QuickOpen::QuickOpen(ProjectIndexer* indexer, QWidget* parent) :
+    QFrame(parent, Qt::Popup),
+    indexer(indexer)
+{
+    setFrameShape(QFrame::StyledPanel);
+    builder.setMaxThreadCount(1);
+
+    queryLineEdit = new QLineEdit(this);
+    queryLineEdit->setPlaceholderText(tr("Go to file"));
+    queryLineEdit->installEventFilter(this);
+    resultsList = new QListWidget(this);
+    resultsList->setUniformItemSizes(true);
+    resultsList->setFocusPolicy(Qt::NoFocus); // typing always goes to the line edit, the arrows are forwarded
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->setContentsMargins(4, 4, 4, 4);
+    layout->addWidget(queryLineEdit);
+    layout->addWidget(resultsList);
+
+    connect(queryLineEdit, &QLineEdit::textEdited, this, &QuickOpen::updateResults);
+    connect(resultsList, &QListWidget::itemActivated, this, &QuickOpen::chooseCurrent);
+
+    connect(indexer, &ProjectIndexer::indexReady, this, &QuickOpen::rebuild);
+    connect(indexer, &ProjectIndexer::filesUpdated, this, &QuickOpen::filesUpdated);
+    if(indexer->isReady()) rebuild();
+}
+
+QuickOpen::~QuickOpen()
+{
+    builder.waitForDone(); // the task doesnt touch this, but the invoke it queues does
+}
+
+void QuickOpen::popup()
+{
+    const QWidget* window = parentWidget()->window();
+    const int width = qBound(300, window->width() / 2, 700);
+    const int height = qMin(400, window->height() - 40);
+    const QPoint topCenter = window->mapToGlobal(QPoint(window->width() / 2, 0));
+    setGeometry(topCenter.x() - width / 2, topCenter.y() + 20, width, height);
+
+    queryLineEdit->clear();
+    resultsList->clear();
+    show();
+    queryLineEdit->setFocus();
+}
+
+void QuickOpen::rebuild()
+{
+    if(indexer->root() != root) index = PathIndex(); // another folder, its old paths shouldnt be offered meanwhile
+    root = indexer->root();
+
+    const QList<IndexedFile> files = indexer->files();
+    QStringList paths;
+    paths.reserve(files.size());
+    for(const IndexedFile& file : files) paths.append(file.path);
+
+    const quint64 generation = ++buildGeneration;
+    building = true;
+    rebuildPending = false;
+    builder.start([this, generation, paths = std::move(paths)]{
+        const std::shared_ptr<PathIndex> built = std::make_shared<PathIndex>(paths);
+        QMetaObject::invokeMethod(this, [this, generation, built]{ rebuilt(generation, built); }, Qt::QueuedConnection);
+    });
+}
+
+void QuickOpen::rebuilt(quint64 generation, const std::shared_ptr<PathIndex>& built)
+{
+    if(generation != buildGeneration) return; // a newer build is on its way
+
+    building = false;
+    index = std::move(*built);
+    if(rebuildPending){
+        rebuild();
+        return;
+    }
+    if(isVisible()) updateResults();
+}
+
+void QuickOpen::filesUpdated(const QStringList& updated, const QStringList& removed)
+{
+    if(building){
+        rebuildPending = true;
+        return;
+    }
+    if(indexer->root() != root){
+        rebuild(); // updates for a folder this index was never built from
+        return;
+    }
+
+    for(const QString& path : removed) index.remove(path);
+    for(const QString& path : updated) index.add(path); // already there for a changed file, so only new ones get added
+
+    // removed paths keep their slot, once theyre most of the index its worth starting over
+    if(index.removedCount() > index.size()) rebuild();
+    else if(isVisible()) updateResults();
+}
+
+void QuickOpen::updateResults()
+{
+    const QVector<PathIndex::Match> matches = index.find(queryLineEdit->text(), maxResults);
+
+    resultsList->clear();
+    for(const PathIndex::Match& match : matches){
+        const QString& path = index.path(match.id);
+        const qsizetype nameStart = path.lastIndexOf(u'/') + 1;
+
+        QListWidgetItem* item = new QListWidgetItem(resultsList);
+        if(nameStart == 0) item->setText(path);
+        else item->setText(path.mid(nameStart) + "    " + path.left(nameStart - 1));
+        item->setData(Qt::UserRole, path);
+        item->setToolTip(path);
+    }
+    if(resultsList->count() > 0) resultsList->setCurrentRow(0);
+}
+
+void QuickOpen::chooseCurrent()
+{
+    const QListWidgetItem* item = resultsList->currentItem();
+    if(item == nullptr) return;
+
+    const QString filePath = root + "/" + item->data(Qt::UserRole).toString();
+    hide();
+    emit fileChosen(filePath);
+}
+
+bool QuickOpen::eventFilter(QObject* watched, QEvent* event)
+{
+    if(watched != queryLineEdit || event->type() != QEvent::KeyPress) return QFrame::eventFilter(watched, event);
+
+    const QKeyEvent* keyEvent = static_cast<QKeyEvent*>(event);
+    switch(keyEvent->key()){
+    case Qt::Key_Up:
+    case Qt::Key_Down:
+    case Qt::Key_PageUp:
+    case Qt::Key_PageDown:
+        QCoreApplication::sendEvent(resultsList, event);
+        return true;
+    case Qt::Key_Return:
+    case Qt::Key_Enter:
+        chooseCurrent();
+        return true;
+    case Qt::Key_Escape:
+        hide();
+        return true;
+    default:
+        return QFrame::eventFilter(watched, event);
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef QUICKOPEN_H
+#define QUICKOPEN_H
+
+#include <QFrame>
+#include <QThreadPool>
+#include <memory>
+#include "pathindex.h"
+
+class QLineEdit;
+class QListWidget;
+class ProjectIndexer;
+
+// the Ctrl+P palette: type part of a file's path, pick it from the best fuzzy matches, and its opened
+// the paths come from the ProjectIndexer and are kept in a PathIndex, rebuilt off the gui thread when the whole
+// index changes and updated in place for the few files a directory change touches. every keystroke only
+// searches the PathIndex and fills in at most maxResults rows, so the list keeps up with typing
+class QuickOpen : public QFrame
+{
+    Q_OBJECT
+public:
+    QuickOpen(ProjectIndexer* indexer, QWidget* parent);
+    ~QuickOpen(); // waits for a rebuild thats still running
+
+    void popup(); // near the top of the window, with an empty query
+
+signals:
+    void fileChosen(const QString& filePath); // absolute
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
+private:
+    void rebuild();
+    void rebuilt(quint64 generation, const std::shared_ptr<PathIndex>& built);
+    void filesUpdated(const QStringList& updated, const QStringList& removed);
+    void updateResults();
+    void chooseCurrent();
+
+private:
+    inline static constexpr int maxResults = 50;
+
+    ProjectIndexer* indexer; // non-owning
+    PathIndex index;
+    QString root; // what the paths in index are relative to
+
+    QThreadPool builder; // one thread, an index is only ever built from the latest file list
+    quint64 buildGeneration = 0;
+    bool building = false;
+    bool rebuildPending = false; // files changed while building, the built index would be missing them
+
+    QLineEdit* queryLineEdit;
+    QListWidget* resultsList;
+};
+
+#endif // QUICKOPEN_H
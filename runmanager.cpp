@@ -0,0 +1,103 @@
+#include "runmanager.h"
+#include "runsession.h"
+#include <QFileInfo>
+#include <QTabBar>
+#include <QTabWidget>
+#include <QThread>
+
+RunManager::RunManager(QTabWidget* tabs, QObject* parent) :
+    QObject(parent),
+    tabs(tabs),
+    pool(this),
+    maxConcurrentRuns(qMax(1, QThread::idealThreadCount()))
+{
+    // runs can be closed, the terminal cant
+    tabs->setTabsClosable(true);
+    tabs->tabBar()->setTabButton(0, QTabBar::RightSide, nullptr);
+    tabs->tabBar()->setTabButton(0, QTabBar::LeftSide, nullptr);
+    connect(tabs, &QTabWidget::tabCloseRequested, this, &RunManager::closeTab);
+}
+
+void RunManager::run(const QString& filePath)
+{
+    RunSession* session = finishedSessionFor(filePath);
+    if(session == nullptr){
+        session = new RunSession(filePath, settings.terminalScrollback(), tabs);
+        connect(session, &RunSession::rerunRequested, this, &RunManager::schedule);
+        connect(session, &RunSession::stateChanged, this, [this](RunSession* changed){
+            updateTab(changed);
+            if(changed->state() == RunSession::RunState::Idle) startQueued(); // a slot just opened up, or a queued one was cancelled
+        });
+
+        const int tab = tabs->addTab(session, QFileInfo(filePath).fileName());
+        tabs->setTabToolTip(tab, filePath);
+    }
+
+    tabs->setCurrentWidget(session);
+    schedule(session);
+}
+
+void RunManager::warmUp()
+{
+    pool.warmUp();
+}
+
+void RunManager::schedule(RunSession* session)
+{
+    if(runningCount() < maxConcurrentRuns){
+        session->start(pool.take());
+        return;
+    }
+
+    session->queue();
+    queued.append(session);
+}
+
+void RunManager::startQueued()
+{
+    while(!queued.isEmpty() && runningCount() < maxConcurrentRuns){
+        const QPointer<RunSession> next = queued.takeFirst();
+        if(next == nullptr || next->state() != RunSession::RunState::Queued) continue; // closed or cancelled since
+        next->start(pool.take());
+    }
+}
+
+int RunManager::runningCount() const
+{
+    int running = 0;
+    for(int i = 0; i < tabs->count(); ++i){
+        const RunSession* session = qobject_cast<RunSession*>(tabs->widget(i));
+        if(session != nullptr && session->state() == RunSession::RunState::Running) ++running;
+    }
+    return running;
+}
+
+RunSession* RunManager::finishedSessionFor(const QString& filePath) const
+{
+    for(int i = 0; i < tabs->count(); ++i){
+        RunSession* session = qobject_cast<RunSession*>(tabs->widget(i));
+        if(session != nullptr && session->filePath() == filePath && session->state() == RunSession::RunState::Idle) return session;
+    }
+    return nullptr;
+}
+
+void RunManager::updateTab(RunSession* session)
+{
+    const int tab = tabs->indexOf(session);
+    if(tab < 0) return;
+
+    QString title = QFileInfo(session->filePath()).fileName();
+    if(session->state() == RunSession::RunState::Running) title += " *";
+    else if(session->state() == RunSession::RunState::Queued) title += " ...";
+    tabs->setTabText(tab, title);
+}
+
+void RunManager::closeTab(int index)
+{
+    RunSession* session = qobject_cast<RunSession*>(tabs->widget(index));
+    if(session == nullptr) return; // the terminal
+
+    tabs->removeTab(index);
+    delete session; // hands a run thats still going to the ProcessReaper
+    startQueued();
+}
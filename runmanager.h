@@ -0,0 +1,40 @@
+#ifndef RUNMANAGER_H
+#define RUNMANAGER_H
+
+#include <QObject>
+#include <QList>
+#include <QPointer>
+#include "interpreterpool.h"
+#include "settingshelper.h"
+
+class QTabWidget;
+class RunSession;
+
+// starts runs of files, each in its own process with its own tab next to the terminal
+// as many run at once as there are cores, anything past that waits in a queue and starts as soon as one finishes.
+// running a file again reuses its tab if that run is over, or opens another tab so both run side by side
+class RunManager : public QObject
+{
+public:
+    RunManager(QTabWidget* tabs, QObject* parent);
+
+    void run(const QString& filePath);
+    void warmUp(); // a python file was opened, get interpreters ready before the first run
+
+private:
+    void schedule(RunSession* session);
+    void startQueued();
+    int runningCount() const;
+    RunSession* finishedSessionFor(const QString& filePath) const;
+    void updateTab(RunSession* session);
+    void closeTab(int index);
+
+private:
+    QTabWidget* tabs; // the terminal docks tab widget, the terminal itself stays the first tab
+    SettingsHelper settings;
+    InterpreterPool pool;
+    QList<QPointer<RunSession>> queued; // closed tabs turn into nullptrs
+    const int maxConcurrentRuns;
+};
+
+#endif // RUNMANAGER_H
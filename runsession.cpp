@@ -0,0 +1,215 @@
+#include "runsession.h"
+#include "interpreterpool.h"
+#include "processreaper.h"
+#include "util.h"
+#include <QFileInfo>
+#include <QFontDatabase>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPlainTextEdit>
+#include <QScrollBar>
+#include <QToolButton>
+#include <QVBoxLayout>
+#include <utility>
+
+RunSession::RunSession(const QString& filePath, int scrollbackLines, QWidget* parent) :
+    QWidget(parent),
+    path(filePath),
+    statusLabel(new QLabel(this)),
+    stopButton(new QToolButton(this)),
+    rerunButton(new QToolButton(this)),
+    outputView(new QPlainTextEdit(this)),
+    inputLine(new QLineEdit(this))
+{
+    stopButton->setText(tr("Stop"));
+    rerunButton->setText(tr("Rerun"));
+    connect(stopButton, &QToolButton::clicked, this, &RunSession::stop);
+    connect(rerunButton, &QToolButton::clicked, this, [this]{ emit rerunRequested(this); });
+
+    outputView->setReadOnly(true);
+    outputView->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    outputView->setMaximumBlockCount(scrollbackLines); // same limit as the terminal
+    outputView->setLineWrapMode(QPlainTextEdit::NoWrap);
+
+    inputLine->setPlaceholderText(tr("Input for the script, Enter sends it"));
+    connect(inputLine, &QLineEdit::returnPressed, this, &RunSession::sendInput);
+
+    QHBoxLayout* controls = new QHBoxLayout;
+    controls->addWidget(statusLabel, 1);
+    controls->addWidget(stopButton);
+    controls->addWidget(rerunButton);
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(2);
+    layout->addLayout(controls);
+    layout->addWidget(outputView);
+    layout->addWidget(inputLine);
+
+    flushTimer.setSingleShot(true);
+    flushTimer.setInterval(frameInterval);
+    connect(&flushTimer, &QTimer::timeout, this, &RunSession::flushOutput);
+
+    setState(RunState::Idle);
+}
+
+RunSession::~RunSession()
+{
+    if(process != nullptr){
+        process->terminate();
+        ProcessReaper::instance()->adopt(process);
+    }
+}
+
+void RunSession::queue()
+{
+    outputView->clear();
+    appendNote(tr("waiting for another run to finish"));
+    setState(RunState::Queued);
+}
+
+void RunSession::start(QProcess* warmInterpreter)
+{
+    if(currentState != RunState::Queued) outputView->clear(); // queue already cleared it, and said why it waited
+    pendingOutput.clear();
+    decoder.resetState();
+
+    if(warmInterpreter != nullptr){
+        process = warmInterpreter;
+        process->setParent(this);
+    }
+    else{
+        process = new QProcess(this);
+        process->setProcessChannelMode(QProcess::MergedChannels);
+        process->setWorkingDirectory(QFileInfo(path).absolutePath());
+    }
+
+    connect(process, &QProcess::readyRead, this, &RunSession::readOutput);
+    connect(process, &QProcess::finished, this, &RunSession::processFinished);
+    connect(process, &QProcess::errorOccurred, this, &RunSession::processError);
+
+    runTime.start();
+    setState(RunState::Running);
+
+    if(warmInterpreter != nullptr) process->write(QFileInfo(path).absoluteFilePath().toUtf8() + "\n");
+    else process->start(util::getPythonRunCommand(), InterpreterPool::coldArguments(path));
+}
+
+void RunSession::stop()
+{
+    if(currentState == RunState::Queued){
+        appendNote(tr("cancelled"));
+        setState(RunState::Idle);
+        return;
+    }
+    if(process == nullptr) return;
+
+    // whatever it printed before being stopped is still shown
+    readOutput();
+    flushOutput();
+
+    process->terminate();
+    ProcessReaper::instance()->adopt(process); // kills it if it ignores being terminated, without waiting here
+    process = nullptr;
+
+    appendNote(tr("stopped after %1 s").arg(runTime.elapsed() / 1000.0, 0, 'f', 2));
+    setState(RunState::Idle);
+}
+
+void RunSession::setState(RunState state)
+{
+    currentState = state;
+
+    stopButton->setEnabled(state != RunState::Idle);
+    rerunButton->setEnabled(state == RunState::Idle);
+    inputLine->setEnabled(state == RunState::Running);
+
+    const QString fileName = QFileInfo(path).fileName();
+    switch(state){
+    case RunState::Idle:
+        statusLabel->setText(fileName);
+        break;
+    case RunState::Queued:
+        statusLabel->setText(tr("%1 (queued)").arg(fileName));
+        break;
+    case RunState::Running:
+        statusLabel->setText(tr("%1 (running)").arg(fileName));
+        break;
+    }
+
+    emit stateChanged(this);
+}
+
+void RunSession::readOutput()
+{
+    if(process == nullptr) return;
+
+    pendingOutput.append(process->readAll());
+    if(!pendingOutput.isEmpty() && !flushTimer.isActive()) flushTimer.start();
+}
+
+void RunSession::flushOutput()
+{
+    flushTimer.stop();
+    if(pendingOutput.isEmpty()) return;
+
+    // the decoder holds on to a character split between two reads
+    const QString text = decoder.decode(std::exchange(pendingOutput, QByteArray()));
+
+    QScrollBar* scrollBar = outputView->verticalScrollBar();
+    const bool following = scrollBar->value() == scrollBar->maximum();
+
+    QTextCursor end(outputView->document());
+    end.movePosition(QTextCursor::End);
+    end.insertText(text);
+
+    if(following) scrollBar->setValue(scrollBar->maximum());
+}
+
+void RunSession::appendNote(const QString& note)
+{
+    flushOutput();
+
+    QTextCursor end(outputView->document());
+    end.movePosition(QTextCursor::End);
+    if(!end.atBlockStart()) end.insertText("\n");
+    end.insertText("[" + note + "]\n");
+
+    outputView->verticalScrollBar()->setValue(outputView->verticalScrollBar()->maximum());
+}
+
+void RunSession::processFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    readOutput();
+    flushOutput();
+
+    const QString seconds = QString::number(runTime.elapsed() / 1000.0, 'f', 2);
+    if(exitStatus == QProcess::CrashExit) appendNote(tr("crashed after %1 s").arg(seconds));
+    else appendNote(tr("finished with exit code %1 in %2 s").arg(exitCode).arg(seconds));
+
+    std::exchange(process, nullptr)->deleteLater();
+    setState(RunState::Idle);
+}
+
+void RunSession::processError(QProcess::ProcessError error)
+{
+    if(error != QProcess::FailedToStart) return; // crashes come through finished as well
+
+    appendNote(tr("failed to start %1: %2").arg(util::getPythonRunCommand(), process->errorString()));
+    std::exchange(process, nullptr)->deleteLater();
+    setState(RunState::Idle);
+}
+
+void RunSession::sendInput()
+{
+    if(process == nullptr) return;
+
+    const QByteArray line = inputLine->text().toUtf8() + "\n";
+    inputLine->clear();
+    process->write(line);
+
+    // nothing echoes on a pipe, so it shows up in the output like it would in a terminal
+    pendingOutput.append(line);
+    if(!flushTimer.isActive()) flushTimer.start();
+}
@@ -0,0 +1,76 @@
+#ifndef RUNSESSION_H
+#define RUNSESSION_H
+
+#include <QWidget>
+#include <QProcess>
+#include <QElapsedTimer>
+#include <QStringDecoder>
+#include <QTimer>
+
+class QLabel;
+class QLineEdit;
+class QPlainTextEdit;
+class QToolButton;
+
+// one run of a file, and the pane in the terminal dock that shows it: its output, a line to type input for
+// the script into, and stop/rerun buttons. every run is its own process, so runs dont share a shell or each
+// others output. output is collected as it arrives and put on screen at most once a frame
+class RunSession : public QWidget
+{
+    Q_OBJECT
+public:
+    enum class RunState{
+        Idle, // never started, or finished
+        Queued, // waiting for another run to finish
+        Running
+    };
+
+    RunSession(const QString& filePath, int scrollbackLines, QWidget* parent);
+    ~RunSession(); // a run still going is handed to the ProcessReaper
+
+    inline QString filePath() const
+    {
+        return path;
+    }
+    inline RunState state() const
+    {
+        return currentState;
+    }
+
+    void queue();
+    void start(QProcess* warmInterpreter); // nullptr starts a new interpreter for this run
+    void stop();
+
+signals:
+    void rerunRequested(RunSession* session);
+    void stateChanged(RunSession* session);
+
+private:
+    void setState(RunState state);
+    void readOutput();
+    void flushOutput();
+    void appendNote(const QString& note); // the [bracketed] lines that arent the scripts own output
+    void processFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void processError(QProcess::ProcessError error);
+    void sendInput();
+
+private:
+    inline static constexpr int frameInterval = 16; // milliseconds between output flushes
+
+    QString path;
+    RunState currentState = RunState::Idle;
+    QProcess* process = nullptr;
+    QElapsedTimer runTime;
+
+    QByteArray pendingOutput;
+    QStringDecoder decoder{QStringDecoder::Utf8};
+    QTimer flushTimer;
+
+    QLabel* statusLabel;
+    QToolButton* stopButton;
+    QToolButton* rerunButton;
+    QPlainTextEdit* outputView;
+    QLineEdit* inputLine;
+};
+
+#endif // RUNSESSION_H
@@ -1,22 +1,51 @@
 #include "searchandreplace.h"
+#include "multicursor.h"
 #include <QBoxLayout>
 #include <QStyle>
 // #include "ui_mainwindow.h"
 #include <QApplication>
+#include <QScrollBar>
+#include <QTextBlock>
+#include <QToolTip>
+#include <algorithm>
 
-SearchAndReplace::SearchAndReplace(QPlainTextEdit* editor)
+SearchAndReplace::SearchAndReplace(QPlainTextEdit* editor, TextBuffer* buffer, SelectionLayers* layers, MultiCursor* multiCursor)
     : QDockWidget(editor),
-    editor(editor)
+    editor(editor),
+    buffer(buffer),
+    layers(layers),
+    multiCursor(multiCursor)
 {
     setupUI(); // makes the ui items and signal connections in constructor
     connectSignalsAndSlots();
     this->hide();
 
+    searchWorker = new SearchWorker(&latestGeneration);
+    searchWorker->moveToThread(&searchThread);
+    connect(&searchThread, &QThread::finished, searchWorker, &QObject::deleteLater);
+    connect(searchWorker, &SearchWorker::matchesFound, this, &SearchAndReplace::onMatchesFound);
+    connect(searchWorker, &SearchWorker::searchFinished, this, &SearchAndReplace::onSearchFinished);
+    connect(searchWorker, &SearchWorker::replaceAllReady, this, &SearchAndReplace::onReplaceAllReady);
+    connect(searchWorker, &SearchWorker::invalidPattern, this, &SearchAndReplace::onInvalidPattern);
+
+    // the overlay only covers the matches on screen, so it follows the view around
+    connect(editor->verticalScrollBar(), &QScrollBar::valueChanged, this, &SearchAndReplace::refreshHighlights);
+    connect(editor->verticalScrollBar(), &QScrollBar::rangeChanged, this, &SearchAndReplace::refreshHighlights);
 }
 SearchAndReplace::~SearchAndReplace() {
+    if(searchThread.isRunning()){
+        latestGeneration++; // makes a running search give up at its next chunk
+        searchThread.quit();
+        searchThread.wait();
+    }
+    else{
+        delete searchWorker; // never moved onto a running thread, so nothing else deletes it
+    }
+
     foundOccurrences.clear();
     delete isMatchWholeWord;
     delete isCaseSensitive;
+    delete isRegularExpression;
 }
 
 void SearchAndReplace::setupUI(){
@@ -41,6 +70,7 @@ void SearchAndReplace::setupUI(){
     //             Another Qhbox aligned to right --checkboxesparent
     //                 Match whole word button
     //                 Case sensitive button
+    //                 Regular expression button
 
 
     // Ceates the ui objects in the structure above
@@ -96,6 +126,8 @@ void SearchAndReplace::setupUI(){
     QHBoxLayout* bottomLayout = new QHBoxLayout(bottomEmptyWidget);
 
     replaceTextButton = new QPushButton("Replace All");
+    selectAllButton = new QPushButton("Select All");
+    selectAllButton->setToolTip("Put a cursor on every match");
 
     QHBoxLayout* checkBoxesParent = new QHBoxLayout;
 
@@ -107,9 +139,13 @@ void SearchAndReplace::setupUI(){
     isMatchWholeWord = new QCheckBox;
     checkBoxesParent->addWidget(isMatchWholeWord);
 
+    isRegularExpression = new QCheckBox;
+    checkBoxesParent->addWidget(isRegularExpression);
+
     iterateWordsLayout->addLayout(prevAndNextButtonsLayout);
 
     bottomLayout->addWidget(replaceTextButton);
+    bottomLayout->addWidget(selectAllButton);
     bottomLayout->addLayout(checkBoxesParent);
 
 
@@ -129,6 +165,10 @@ void SearchAndReplace::setupUI(){
     QIcon matchWholeIcon = QIcon(":/imgs/whole-word.svg");
     isMatchWholeWord->setIcon(matchWholeIcon);
 
+    isRegularExpression->setToolTip("Use Regular Expression (\\1 in the replace box inserts the first group)");
+    QIcon regexIcon = QIcon(":/imgs/regex.svg");
+    isRegularExpression->setIcon(regexIcon);
+
     qApp->setStyleSheet(" QCheckBox:hover{background-color: light-gray;}");
 
     searchTextLineEdit->setPlaceholderText("Search Text");
@@ -136,6 +176,7 @@ void SearchAndReplace::setupUI(){
     replaceTextLineEdit->setPlaceholderText("Replace With");
     replaceTextLineEdit->setFixedSize(160, 20);
     replaceTextButton->setFixedSize(120, 20);
+    selectAllButton->setFixedSize(80, 20);
 
 
     searchAndReplaceParent->setSpacing(2);
@@ -153,7 +194,12 @@ void SearchAndReplace::connectSignalsAndSlots() {
         searchForText(searchTextLineEdit->text());
     }); // redoes the search if either button is clicked
 
+    connect(isRegularExpression, &QCheckBox::clicked, this, [this](){
+        searchForText(searchTextLineEdit->text());
+    });
+
     connect(replaceTextButton, &QPushButton::clicked, this, &SearchAndReplace::onReplaceClicked);
+    connect(selectAllButton, &QPushButton::clicked, this, &SearchAndReplace::onSelectAllClicked);
 
     connect(searchTextLineEdit, &QLineEdit::textEdited, this, [this]{
         searchForText(searchTextLineEdit->text());
@@ -165,81 +211,179 @@ void SearchAndReplace::onReplaceClicked() {
     if (replaceText.isEmpty() || foundOccurrences.isEmpty()) {
         return;  // If the replacement text is empty or no occurrences found, do nothing.
     }
+    if (!searchComplete || resultsAreStale()) {
+        return; // the positions only line up with the text the search ran on
+    }
 
-    QTextCursor cursor = editor->textCursor();
-    cursor.beginEditBlock();  // Start a single undo block for the whole replacement operation.
+    // the worker builds the replaced text in one pass, the document then only gets edited once
+    const quint64 generation = ++latestGeneration;
+    QMetaObject::invokeMethod(searchWorker, [worker = searchWorker, generation, revision = buffer->revision(), snapshot = *buffer,
+                                             query = currentQuery(), replaceText, matches = foundOccurrences]{
+        worker->replaceAll(generation, revision, snapshot, query, replaceText, matches);
+    }, Qt::QueuedConnection);
+}
 
-    for (QTextCursor &occurrence : foundOccurrences) { // loops through the vector storing all instances of the items to removed
-        occurrence.beginEditBlock();
-        occurrence.insertText(replaceText);
-        occurrence.endEditBlock();
+void SearchAndReplace::onSelectAllClicked()
+{
+    if (foundOccurrences.isEmpty() || !searchComplete || resultsAreStale()) {
+        return; // same as replacing, the positions have to match the text as it is now
     }
 
-    cursor.endEditBlock();  // End the undo block.
+    QVector<MultiCursor::Caret> carets;
+    carets.reserve(foundOccurrences.size());
+    for (const SearchMatch& match : std::as_const(foundOccurrences)) {
+        carets.append(MultiCursor::Caret{int(match.start), int(match.start + match.length)});
+    }
+
+    removeHighlights(); // the cursors selections show where the matches are now
+    close();
+    multiCursor->setCarets(carets);
+}
+
+void SearchAndReplace::onReplaceAllReady(quint64 generation, quint64 revision, const SearchReplacement& span, qsizetype count)
+{
+    if (generation != latestGeneration.load()) return;
+    if (revision != buffer->revision()) return; // edited while the worker was busy, the positions dont line up anymore
+    if (count == 0) return;
+
+    removeHighlights();
+
+    // a single insert over the whole span, so its one undo step and one relayout however many matches there were
+    cursorFor(SearchMatch{span.start, span.length}).insertText(span.text);
+
     foundOccurrences.clear();  // Clear occurrences after replacement
+    selectedOccurenceIndex = 0;
+    updateOccurrenceLabel();
+
+    QToolTip::showText(replaceTextButton->mapToGlobal(QPoint(0, replaceTextButton->height())),
+                       QString::number(count) + (count == 1 ? " occurrence replaced" : " occurrences replaced"),
+                       replaceTextButton);
+}
+
+void SearchAndReplace::onInvalidPattern(quint64 generation, const QString& message)
+{
+    if (generation != latestGeneration.load()) return;
+
+    searchComplete = true;
+    searchTextLineEdit->setStyleSheet("QLineEdit{border: 1px solid red;}");
+    searchTextLineEdit->setToolTip(message);
+}
+
+SearchQuery SearchAndReplace::currentQuery() const
+{
+    SearchQuery query;
+    query.text = searchTextLineEdit->text();
+    query.caseSensitivity = isCaseSensitive->isChecked() ? Qt::CaseSensitive : Qt::CaseInsensitive;
+    query.wholeWords = isMatchWholeWord->isChecked();
+    query.regularExpression = isRegularExpression->isChecked();
+    return query;
 }
 
 
 void SearchAndReplace::searchForText(const QString& text){
+    const quint64 generation = ++latestGeneration; // a search still running for the old text stops
 
     removeHighlights(); // removes any text that was previously highlighted
     foundOccurrences.clear(); // clears the vector storing all instances
+    selectedOccurenceIndex = 0;
+    updateOccurrenceLabel();
+    searchTextLineEdit->setStyleSheet(""); // clears the invalid pattern marker
+    searchTextLineEdit->setToolTip("");
 
     if (text.isEmpty()) {
+        searchComplete = true;
         return; // returns if empty string
     }
 
-    QTextDocument *document = editor->document();
-    QTextCursor highlightCursor(document);
-    QTextCursor cursor(document);
-
-    cursor.beginEditBlock();
+    SearchQuery query = currentQuery();
+    query.text = text;
 
-    QTextCharFormat plainFormat(highlightCursor.charFormat());
-    QTextCharFormat colorFormat = plainFormat;
-    colorFormat.setBackground(Qt::blue);
+    searchComplete = false;
+    resultsRevision = buffer->revision();
 
-    QTextDocument::FindFlags flag;
+    if (!searchThread.isRunning()) searchThread.start();
 
-    // or equals operator, if true it is added
-    if (isCaseSensitive->isChecked()) flag |= QTextDocument::FindCaseSensitively;
+    // the worker searches a snapshot of the buffer, so the document can keep changing while it runs
+    QMetaObject::invokeMethod(searchWorker, [worker = searchWorker, generation, revision = resultsRevision, snapshot = *buffer, query]{
+        worker->search(generation, revision, snapshot, query);
+    }, Qt::QueuedConnection);
+};
 
-    if (isMatchWholeWord->isChecked()) flag |= QTextDocument::FindWholeWords;
+void SearchAndReplace::onMatchesFound(quint64 generation, const QVector<SearchMatch>& matches)
+{
+    if (generation != latestGeneration.load()) return; // results for a query thats been replaced
 
-    while (!highlightCursor.isNull() && !highlightCursor.atEnd()){
-        highlightCursor = document->find(text, highlightCursor, flag);
+    if (resultsAreStale()) {
+        searchForText(searchTextLineEdit->text()); // the text changed under the search, start over on the new text
+        return;
+    }
 
-        if (!highlightCursor.isNull()){
-            // highlightCursor.movePosition(QTextCursor::WordRight, QTextCursor::KeepAnchor);
-            highlightCursor.mergeCharFormat(colorFormat);
+    foundOccurrences.append(matches);
+    refreshHighlights();
+    updateOccurrenceLabel();
+}
 
-            foundOccurrences.append(highlightCursor);
-        }
-    }
-    cursor.endEditBlock();
+void SearchAndReplace::onSearchFinished(quint64 generation, qsizetype total)
+{
+    Q_UNUSED(total);
+    if (generation != latestGeneration.load()) return;
 
+    searchComplete = true;
     if(foundOccurrences.size() == 0) return; // if an item is found moves the cursor to the last item
 
     selectedOccurenceIndex = foundOccurrences.size();
-    QString labelText = QString::number(selectedOccurenceIndex) + " / " + QString::number(foundOccurrences.size());
-    occurenceIteratorLabel->setText(labelText);
+    selectedMatchColor = Qt::cyan;
+    updateOccurrenceLabel();
 
+    const SearchMatch& last = foundOccurrences.last();
     auto textcursor = editor->textCursor();
-    textcursor.setPosition(foundOccurrences.at(selectedOccurenceIndex-1).position());
+    textcursor.setPosition(last.start + last.length);
     editor->setTextCursor(textcursor);
-};
+    refreshHighlights();
+}
+
+void SearchAndReplace::refreshHighlights()
+{
+    if (resultsAreStale()) return; // the selections already on screen move along with edits, the rest waits for a new search
+
+    QList<QTextEdit::ExtraSelection> selections;
+    if (!isHidden() && !foundOccurrences.isEmpty()) {
+        // matches are sorted and dont overlap, so the ones on screen are one run found by binary search
+        const int firstVisible = editor->cursorForPosition(QPoint(0, 0)).block().position();
+        const QTextBlock lastBlock = editor->cursorForPosition(QPoint(0, editor->viewport()->height() - 1)).block();
+        const qsizetype lastVisible = lastBlock.position() + lastBlock.length();
+
+        auto match = std::partition_point(foundOccurrences.cbegin(), foundOccurrences.cend(), [firstVisible](const SearchMatch& m){
+            return m.start + m.length <= firstVisible;
+        });
+        for (; match != foundOccurrences.cend() && match->start < lastVisible; ++match) {
+            const int occurrenceIndex = int(match - foundOccurrences.cbegin()) + 1;
+
+            QTextEdit::ExtraSelection selection;
+            selection.cursor = cursorFor(*match);
+            selection.format.setBackground(occurrenceIndex == selectedOccurenceIndex ? selectedMatchColor : QColor(Qt::blue));
+            selections.append(selection);
+        }
+    }
+    layers->set(SelectionLayers::SearchMatches, selections);
+}
 
 void SearchAndReplace::removeHighlights(){
-    QTextDocument *document = editor->document();
-    QTextCursor cursor(document);
-    cursor.beginEditBlock();
+    layers->clear(SelectionLayers::SearchMatches); // nothing was written into the document, dropping the overlay is all it takes
+}
 
-    QTextCharFormat plainFormat;
-    plainFormat.setBackground(Qt::transparent); // Set background to transparent to remove highlight
-    cursor.select(QTextCursor::Document);
-    cursor.mergeCharFormat(plainFormat);
+QTextCursor SearchAndReplace::cursorFor(const SearchMatch& match) const
+{
+    QTextCursor cursor(editor->document());
+    cursor.setPosition(match.start);
+    cursor.setPosition(match.start + match.length, QTextCursor::KeepAnchor);
+    return cursor;
+}
 
-    cursor.endEditBlock();
+void SearchAndReplace::updateOccurrenceLabel()
+{
+    QString labelText = QString::number(selectedOccurenceIndex) + " / " + QString::number(foundOccurrences.size());
+    occurenceIteratorLabel->setText(labelText);
 }
 
 void SearchAndReplace::showWidget(){
@@ -248,50 +392,39 @@ void SearchAndReplace::showWidget(){
 }
 
 void SearchAndReplace::goToPreviousSelection() {
-    // same as go to next
-    QTextCursor cursor = foundOccurrences.at(selectedOccurenceIndex-1);
-    QTextCharFormat oldCursorPosFormat;
-    oldCursorPosFormat.setBackground(Qt::blue);
-    cursor.setCharFormat(oldCursorPosFormat);
+    if (foundOccurrences.isEmpty()) return;
+    if (resultsAreStale()) {
+        searchForText(searchTextLineEdit->text()); // positions are off after an edit, search again first
+        return;
+    }
 
-    if (selectedOccurenceIndex == 1) selectedOccurenceIndex = foundOccurrences.size(); // loops it around to restart at the top
+    if (selectedOccurenceIndex <= 1) selectedOccurenceIndex = foundOccurrences.size(); // loops it around to restart at the top
     else selectedOccurenceIndex--;
 
-    QTextCursor currentCursor = foundOccurrences.at(selectedOccurenceIndex - 1);
-    QTextCharFormat currentSelectionFormat;
-    currentSelectionFormat.setBackground(Qt::yellow);
-    currentCursor.setCharFormat(currentSelectionFormat);
+    selectedMatchColor = Qt::yellow;
+    updateOccurrenceLabel();
 
-    QString text = QString::number(selectedOccurenceIndex) + " / " + QString::number(foundOccurrences.size());
-    occurenceIteratorLabel->setText(text);
-
-
-    editor->setTextCursor(currentCursor);
+    editor->setTextCursor(cursorFor(foundOccurrences.at(selectedOccurenceIndex - 1)));
+    refreshHighlights();
 }
 
 void SearchAndReplace::goToNextSelection() {
+    if (foundOccurrences.isEmpty()) return;
+    if (resultsAreStale()) {
+        searchForText(searchTextLineEdit->text());
+        return;
+    }
 
-    // resets the color of the previously selected word back to blue
-    QTextCursor cursor = foundOccurrences.at(selectedOccurenceIndex-1);
-    QTextCharFormat oldCursorPosFormat;
-    oldCursorPosFormat.setBackground(Qt::blue);
-    cursor.setCharFormat(oldCursorPosFormat);
-
-    if (selectedOccurenceIndex == foundOccurrences.size()) selectedOccurenceIndex = 1;
+    if (selectedOccurenceIndex >= foundOccurrences.size()) selectedOccurenceIndex = 1;
     else selectedOccurenceIndex++;
 
-    // changes the current highlighted word color
-    QTextCursor currentCursor = foundOccurrences.at(selectedOccurenceIndex - 1);
-    QTextCharFormat currentSelectionFormat;
-    currentSelectionFormat.setBackground(Qt::cyan);
-    currentCursor.setCharFormat(currentSelectionFormat);
-
-
-    QString text = QString::number(selectedOccurenceIndex) + " / " + QString::number(foundOccurrences.size());
-    occurenceIteratorLabel->setText(text);
+    // the current match gets its own color in the overlay
+    selectedMatchColor = Qt::cyan;
+    updateOccurrenceLabel();
 
     // sets text cursor to the current selection
-    editor->setTextCursor(currentCursor);
+    editor->setTextCursor(cursorFor(foundOccurrences.at(selectedOccurenceIndex - 1)));
+    refreshHighlights();
 }
 
 void SearchAndReplace::closeEvent(QCloseEvent *event)
@@ -11,6 +11,13 @@
 #include <QLabel>
 #include <QCheckBox>
 #include <QFrame>
+#include <QThread>
+#include <atomic>
+#include "textbuffer.h"
+#include "searchworker.h"
+#include "selectionlayers.h"
+
+class MultiCursor;
 
 
 class SearchAndReplace : public QDockWidget
@@ -19,7 +26,7 @@ class SearchAndReplace : public QDockWidget
 
 
 public:
-    explicit SearchAndReplace(QPlainTextEdit* editor);
+    SearchAndReplace(QPlainTextEdit* editor, TextBuffer* buffer, SelectionLayers* layers, MultiCursor* multiCursor);
     ~SearchAndReplace();
 
 protected slots:
@@ -32,24 +39,52 @@ public slots:
     void setupUI();
     void connectSignalsAndSlots();
     void onReplaceClicked();
+    void onSelectAllClicked(); // a cursor on every match
     void removeHighlights();
     void showWidget();
     void goToPreviousSelection();
     void goToNextSelection();
 
+private:
+    void onMatchesFound(quint64 generation, const QVector<SearchMatch>& matches); // a chunk of results streaming in
+    void onSearchFinished(quint64 generation, qsizetype total);
+    void onReplaceAllReady(quint64 generation, quint64 revision, const SearchReplacement& span, qsizetype count);
+    void onInvalidPattern(quint64 generation, const QString& message);
+    SearchQuery currentQuery() const; // whats in the search box along with the checkbox options
+    void refreshHighlights(); // redoes the overlay for whatever matches are on screen
+    void updateOccurrenceLabel();
+    QTextCursor cursorFor(const SearchMatch& match) const;
+    inline bool resultsAreStale() const
+    {
+        return buffer->revision() != resultsRevision; // the text changed since the search ran, positions are off
+    }
+
 private:
     QLineEdit* searchTextLineEdit;
     QLineEdit* replaceTextLineEdit;
-    QVector<QTextCursor> foundOccurrences;
+    QVector<SearchMatch> foundOccurrences; // positions instead of cursors, the document doesnt have to track 100k cursors
     QCheckBox* isCaseSensitive;
     QCheckBox* isMatchWholeWord;
+    QCheckBox* isRegularExpression;
     QPushButton* replaceTextButton;
+    QPushButton* selectAllButton;
     QPlainTextEdit* editor;
+    TextBuffer* buffer; // the editors piece table, searched instead of the document (non-owning)
+    SelectionLayers* layers; // the match highlights go in their own layer (non-owning)
+    MultiCursor* multiCursor; // non-owning
 
     QPushButton* nextMatchButton;
     QPushButton* prevMatchButton;
     QLabel* occurenceIteratorLabel;
-    int selectedOccurenceIndex;
+    int selectedOccurenceIndex = 0; // 1 based, 0 means none picked yet
+
+    bool searchComplete = true; // false while results are still streaming in
+    quint64 resultsRevision = 0; // buffer revision the current results were searched at
+    QColor selectedMatchColor = Qt::cyan; // cyan after going to the next match, yellow after going back
+
+    std::atomic<quint64> latestGeneration{0}; // the worker drops any search older than this
+    QThread searchThread; // started on the first search
+    SearchWorker* searchWorker;
 };
 
 #endif // SEARCHANDREPLACE_H
@@ -0,0 +1,115 @@
+// times SearchKernel against the QTextDocument::find loop search used before it, and QStringView::indexOf
+// only built with -DTEXTEDITOR_BENCHMARKS=ON, run it as
+//     searchbenchmark [megabytes] [needle]
+// QTextDocument wants a gui application, QT_QPA_PLATFORM=offscreen works without a display
+#include "searchkernel.h"
+#include <QGuiApplication>
+#include <QTextDocument>
+#include <QTextCursor>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <cstdio>
+#include <functional>
+
+namespace {
+
+// lines of random lowercase words, with the needle dropped in now and then (in upper case every other time)
+QString makeDocument(qsizetype characters, const QString& needle)
+{
+    QRandomGenerator random(42); // the same text every run
+    QString text;
+    text.reserve(characters + 64);
+    qsizetype lineLength = 0;
+    while(text.size() < characters){
+        if(random.bounded(200) == 0){
+            text.append(random.bounded(2) == 0 ? needle : needle.toUpper());
+        }
+        else{
+            const int wordLength = 2 + random.bounded(8);
+            for(int i = 0; i < wordLength; ++i) text.append(QChar(u'a' + random.bounded(26)));
+        }
+        lineLength++;
+        text.append(lineLength % 12 == 0 ? u'\n' : u' ');
+    }
+    return text;
+}
+
+// runs search a few times and prints the fastest, the first run also warms the caches
+void report(const char* name, const std::function<qsizetype()>& search)
+{
+    constexpr int runs = 5;
+    qint64 best = -1;
+    qsizetype matches = 0;
+    for(int i = 0; i < runs; ++i){
+        QElapsedTimer timer;
+        timer.start();
+        matches = search();
+        const qint64 elapsed = timer.nsecsElapsed();
+        if(best == -1 || elapsed < best) best = elapsed;
+    }
+    std::printf("%-40s %10.2f ms %10lld matches\n", name, double(best) / 1e6, static_cast<long long>(matches));
+}
+
+qsizetype countKernel(QStringView haystack, const SearchKernel& kernel)
+{
+    qsizetype count = 0;
+    for(qsizetype index = kernel.indexIn(haystack); index != -1; index = kernel.indexIn(haystack, index + kernel.size())){
+        count++;
+    }
+    return count;
+}
+
+qsizetype countIndexOf(QStringView haystack, QStringView needle, Qt::CaseSensitivity caseSensitivity)
+{
+    qsizetype count = 0;
+    for(qsizetype index = haystack.indexOf(needle, 0, caseSensitivity); index != -1;
+         index = haystack.indexOf(needle, index + needle.size(), caseSensitivity)){
+        count++;
+    }
+    return count;
+}
+
+// how SearchAndReplace found matches before the worker, one find after another from the last match
+qsizetype countDocumentFind(QTextDocument& document, const QString& needle, QTextDocument::FindFlags flags)
+{
+    qsizetype count = 0;
+    QTextCursor cursor(&document);
+    while(true){
+        cursor = document.find(needle, cursor, flags);
+        if(cursor.isNull()) break;
+        count++;
+    }
+    return count;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QGuiApplication app(argc, argv);
+
+    const QStringList arguments = app.arguments();
+    const qsizetype megabytes = arguments.size() > 1 ? arguments.at(1).toLongLong() : 16;
+    const QString needle = arguments.size() > 2 ? arguments.at(2) : QStringLiteral("needle");
+    if(megabytes <= 0 || needle.isEmpty()){
+        std::fprintf(stderr, "usage: searchbenchmark [megabytes] [needle]\n");
+        return 1;
+    }
+
+    const QString text = makeDocument(megabytes * 1024 * 1024 / 2, needle); // utf 16, two bytes a character
+    std::printf("%lld characters, searching for \"%s\"\n\n", static_cast<long long>(text.size()), qPrintable(needle));
+
+    const SearchKernel sensitive(needle, Qt::CaseSensitive);
+    const SearchKernel insensitive(needle, Qt::CaseInsensitive);
+    report("SearchKernel, case sensitive", [&]{ return countKernel(text, sensitive); });
+    report("SearchKernel, case insensitive", [&]{ return countKernel(text, insensitive); });
+    report("QStringView::indexOf, case sensitive", [&]{ return countIndexOf(text, needle, Qt::CaseSensitive); });
+    report("QStringView::indexOf, case insensitive", [&]{ return countIndexOf(text, needle, Qt::CaseInsensitive); });
+
+    QTextDocument document;
+    document.setPlainText(text);
+    report("QTextDocument::find, case sensitive", [&]{ return countDocumentFind(document, needle, QTextDocument::FindCaseSensitively); });
+    report("QTextDocument::find, case insensitive", [&]{ return countDocumentFind(document, needle, {}); });
+
+    return 0;
+}
@@ -0,0 +1,257 @@
+#include "searchkernel.h"
+#include <QtAlgorithms>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SEARCHKERNEL_SSE2
+#include <emmintrin.h>
+#endif
+
+// avx2 is picked at runtime, the build itself only assumes sse2
+#if defined(SEARCHKERNEL_SSE2) && defined(__GNUC__)
+#define SEARCHKERNEL_AVX2
+#include <immintrin.h>
+#endif
+
+namespace {
+
+enum class InstructionSet { Scalar, Sse2, Avx2 };
+
+InstructionSet detectInstructionSet()
+{
+#if defined(SEARCHKERNEL_AVX2)
+    if(__builtin_cpu_supports("avx2")) return InstructionSet::Avx2;
+#endif
+#if defined(SEARCHKERNEL_SSE2)
+    return InstructionSet::Sse2;
+#else
+    return InstructionSet::Scalar;
+#endif
+}
+
+InstructionSet activeInstructionSet()
+{
+    static const InstructionSet detected = detectInstructionSet();
+    return detected;
+}
+
+inline char16_t foldCase(char16_t c)
+{
+    if(c < 0x80) return (c >= u'A' && c <= u'Z') ? char16_t(c + 0x20) : c;
+    return char16_t(QChar::toCaseFolded(char32_t(c)));
+}
+
+inline bool isWordCharacter(char16_t c)
+{
+    if(c < 0x80){
+        const char16_t lower = c | 0x20;
+        return (lower >= u'a' && lower <= u'z') || (c >= u'0' && c <= u'9');
+    }
+    return QChar(c).isLetterOrNumber();
+}
+
+// what a haystack character has to look like to be worth comparing in full
+struct Filter
+{
+    char16_t first;
+    char16_t last;
+    qsizetype lastOffset; // needle length - 1
+    bool caseInsensitive;
+    bool nonAsciiCandidates;
+
+    inline bool isCandidate(char16_t c, char16_t unit) const
+    {
+        if(!caseInsensitive) return c == unit;
+        if(c >= 0x80) return c == unit || nonAsciiCandidates;
+        return foldCase(c) == unit;
+    }
+};
+
+template<typename Verify>
+qsizetype scanScalar(const char16_t* text, qsizetype from, qsizetype lastStart, const Filter& filter, Verify verify)
+{
+    for(qsizetype i = from; i <= lastStart; ++i){
+        if(filter.isCandidate(text[i], filter.first) && filter.isCandidate(text[i + filter.lastOffset], filter.last)
+            && verify(i)){
+            return i;
+        }
+    }
+    return -1;
+}
+
+#if defined(SEARCHKERNEL_SSE2)
+
+// lowercases A-Z in every lane, leaves everything else alone
+inline __m128i foldAsciiSse2(__m128i v)
+{
+    const __m128i upper = _mm_and_si128(_mm_cmpgt_epi16(v, _mm_set1_epi16(u'A' - 1)),
+                                        _mm_cmplt_epi16(v, _mm_set1_epi16(u'Z' + 1)));
+    return _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi16(0x20)));
+}
+
+// the compares are signed, so units from 0x8000 up show up as negative
+inline __m128i nonAsciiSse2(__m128i v)
+{
+    return _mm_or_si128(_mm_cmpgt_epi16(v, _mm_set1_epi16(0x7F)), _mm_cmplt_epi16(v, _mm_setzero_si128()));
+}
+
+inline __m128i candidatesSse2(__m128i v, __m128i unit, const Filter& filter)
+{
+    if(!filter.caseInsensitive) return _mm_cmpeq_epi16(v, unit);
+
+    __m128i hits = _mm_cmpeq_epi16(foldAsciiSse2(v), unit);
+    if(filter.nonAsciiCandidates) hits = _mm_or_si128(hits, nonAsciiSse2(v));
+    return hits;
+}
+
+template<typename Verify>
+qsizetype scanSse2(const char16_t* text, qsizetype from, qsizetype lastStart, const Filter& filter, Verify verify)
+{
+    constexpr qsizetype lanes = 8;
+    const __m128i first = _mm_set1_epi16(short(filter.first));
+    const __m128i last = _mm_set1_epi16(short(filter.last));
+
+    qsizetype i = from;
+    for(; i + lanes - 1 <= lastStart; i += lanes){
+        const __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+        const __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + filter.lastOffset));
+        uint mask = uint(_mm_movemask_epi8(_mm_and_si128(candidatesSse2(head, first, filter),
+                                                         candidatesSse2(tail, last, filter))));
+        while(mask != 0){
+            const qsizetype position = i + qCountTrailingZeroBits(mask) / 2;
+            if(verify(position)) return position;
+            mask &= mask - 1; // each lane is two bits of the mask
+            mask &= mask - 1;
+        }
+    }
+    return scanScalar(text, i, lastStart, filter, verify);
+}
+
+#endif // SEARCHKERNEL_SSE2
+
+#if defined(SEARCHKERNEL_AVX2)
+
+__attribute__((target("avx2"))) inline __m256i foldAsciiAvx2(__m256i v)
+{
+    const __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi16(v, _mm256_set1_epi16(u'A' - 1)),
+                                           _mm256_cmpgt_epi16(_mm256_set1_epi16(u'Z' + 1), v));
+    return _mm256_or_si256(v, _mm256_and_si256(upper, _mm256_set1_epi16(0x20)));
+}
+
+__attribute__((target("avx2"))) inline __m256i nonAsciiAvx2(__m256i v)
+{
+    return _mm256_or_si256(_mm256_cmpgt_epi16(v, _mm256_set1_epi16(0x7F)),
+                           _mm256_cmpgt_epi16(_mm256_setzero_si256(), v));
+}
+
+__attribute__((target("avx2"))) inline __m256i candidatesAvx2(__m256i v, __m256i unit, const Filter& filter)
+{
+    if(!filter.caseInsensitive) return _mm256_cmpeq_epi16(v, unit);
+
+    __m256i hits = _mm256_cmpeq_epi16(foldAsciiAvx2(v), unit);
+    if(filter.nonAsciiCandidates) hits = _mm256_or_si256(hits, nonAsciiAvx2(v));
+    return hits;
+}
+
+template<typename Verify>
+__attribute__((target("avx2")))
+qsizetype scanAvx2(const char16_t* text, qsizetype from, qsizetype lastStart, const Filter& filter, Verify verify)
+{
+    constexpr qsizetype lanes = 16;
+    const __m256i first = _mm256_set1_epi16(short(filter.first));
+    const __m256i last = _mm256_set1_epi16(short(filter.last));
+
+    qsizetype i = from;
+    for(; i + lanes - 1 <= lastStart; i += lanes){
+        const __m256i head = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+        const __m256i tail = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + filter.lastOffset));
+        uint mask = uint(_mm256_movemask_epi8(_mm256_and_si256(candidatesAvx2(head, first, filter),
+                                                               candidatesAvx2(tail, last, filter))));
+        while(mask != 0){
+            const qsizetype position = i + qCountTrailingZeroBits(mask) / 2;
+            if(verify(position)) return position;
+            mask &= mask - 1;
+            mask &= mask - 1;
+        }
+    }
+    // the last few starts go through sse2 and then scalar
+    return scanSse2(text, i, lastStart, filter, verify);
+}
+
+#endif // SEARCHKERNEL_AVX2
+
+} // namespace
+
+SearchKernel::SearchKernel(QStringView needle, Qt::CaseSensitivity caseSensitivity) :
+    needle(needle.toString()),
+    caseSensitivity(caseSensitivity)
+{
+    if(caseSensitivity == Qt::CaseInsensitive && !this->needle.isEmpty()){
+        for(QChar& c : this->needle){
+            c = QChar(foldCase(c.unicode()));
+        }
+        // characters like the kelvin sign fold to plain ascii letters, and anything non ascii (letters, but also
+        // symbols like the circled letters) can have other forms folding into it. only an ascii non letter at
+        // both ends rules out every non ascii character there
+        auto couldBeFoldedInto = [](QChar c){
+            return c.unicode() >= 0x80 || c.isLetter();
+        };
+        nonAsciiCandidates = couldBeFoldedInto(this->needle.front()) || couldBeFoldedInto(this->needle.back());
+    }
+}
+
+bool SearchKernel::matchesAt(QStringView haystack, qsizetype position) const
+{
+    const qsizetype length = needle.size();
+    if(position < 0 || position + length > haystack.size()) return false;
+
+    const char16_t* text = haystack.utf16() + position;
+    const char16_t* pattern = needle.utf16();
+    if(caseSensitivity == Qt::CaseSensitive){
+        return std::memcmp(text, pattern, size_t(length) * sizeof(char16_t)) == 0;
+    }
+
+    for(qsizetype i = 0; i < length; ++i){
+        if(text[i] != pattern[i] && foldCase(text[i]) != pattern[i]) return false;
+    }
+    return true;
+}
+
+qsizetype SearchKernel::indexIn(QStringView haystack, qsizetype from) const
+{
+    from = qMax<qsizetype>(from, 0);
+    if(needle.isEmpty()) return from <= haystack.size() ? from : -1;
+
+    const qsizetype lastStart = haystack.size() - needle.size();
+    if(from > lastStart) return -1;
+
+    Filter filter;
+    filter.first = needle.front().unicode();
+    filter.last = needle.back().unicode();
+    filter.lastOffset = needle.size() - 1;
+    filter.caseInsensitive = caseSensitivity == Qt::CaseInsensitive;
+    filter.nonAsciiCandidates = nonAsciiCandidates;
+
+    const char16_t* text = haystack.utf16();
+    auto verify = [this, haystack](qsizetype position){
+        return matchesAt(haystack, position);
+    };
+
+    switch(activeInstructionSet()){
+#if defined(SEARCHKERNEL_AVX2)
+    case InstructionSet::Avx2: return scanAvx2(text, from, lastStart, filter, verify);
+#endif
+#if defined(SEARCHKERNEL_SSE2)
+    case InstructionSet::Sse2: return scanSse2(text, from, lastStart, filter, verify);
+#endif
+    default: break;
+    }
+    return scanScalar(text, from, lastStart, filter, verify);
+}
+
+bool SearchKernel::isWholeWord(QStringView text, qsizetype start, qsizetype length)
+{
+    const qsizetype end = start + length;
+    return (start == 0 || !isWordCharacter(text.utf16()[start - 1]))
+           && (end == text.size() || !isWordCharacter(text.utf16()[end]));
+}
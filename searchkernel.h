@@ -0,0 +1,35 @@
+#ifndef SEARCHKERNEL_H
+#define SEARCHKERNEL_H
+
+#include <QString>
+#include <QStringView>
+
+// literal text search over raw utf 16, what SearchWorker uses instead of QStringView::indexOf
+// candidates are found by checking the first and last character of the needle against 8 (sse2) or
+// 16 (avx2) characters at a time, and only those spots get compared in full. case insensitive search
+// folds ascii inside the vector registers, anything non ascii is left to QChar's case folding
+// doesnt touch any gui objects, so it can run on any thread
+class SearchKernel
+{
+public:
+    SearchKernel(QStringView needle, Qt::CaseSensitivity caseSensitivity);
+
+    // position of the first match starting at or after from, -1 if there isnt one
+    qsizetype indexIn(QStringView haystack, qsizetype from = 0) const;
+    bool matchesAt(QStringView haystack, qsizetype position) const;
+
+    inline qsizetype size() const
+    {
+        return needle.size();
+    }
+
+    // same rule as QTextDocument::FindWholeWords, no letter or number touching either side
+    static bool isWholeWord(QStringView text, qsizetype start, qsizetype length);
+
+private:
+    QString needle; // already case folded when the search is case insensitive
+    Qt::CaseSensitivity caseSensitivity;
+    bool nonAsciiCandidates = false; // case insensitive and non ascii text could fold into either end of the needle
+};
+
+#endif // SEARCHKERNEL_H
@@ -0,0 +1,249 @@
+#include "searchworker.h"
+#include "searchkernel.h"
+
+namespace {
+
+// runs the expression over the whole text and calls function with every match that passes the whole word check
+// returns false if a newer search came along before it got to the end
+template<typename Cancelled, typename Function>
+bool forEachRegexMatch(const QRegularExpression& regex, const QString& subject, bool wholeWords, Cancelled cancelled, Function function)
+{
+    QRegularExpressionMatchIterator matches = regex.globalMatch(subject);
+    while(matches.hasNext()){
+        if(cancelled()) return false;
+
+        const QRegularExpressionMatch match = matches.next();
+        if(wholeWords && !SearchKernel::isWholeWord(subject, match.capturedStart(), match.capturedLength())) continue;
+        function(match);
+    }
+    return !cancelled();
+}
+
+} // namespace
+
+SearchWorker::SearchWorker(const std::atomic<quint64>* latestGeneration)
+    : QObject{nullptr},
+    latestGeneration(latestGeneration)
+{
+}
+
+void SearchWorker::search(quint64 generation, quint64 revision, TextBuffer snapshot, const SearchQuery& query)
+{
+    if(cancelled(generation) || query.text.isEmpty()) return;
+
+    if(query.regularExpression){
+        searchRegularExpression(generation, snapshot, query);
+        return;
+    }
+
+    const QStringView needle(query.text);
+    const qsizetype needleLength = needle.size();
+    const qsizetype size = snapshot.size();
+    const SearchKernel kernel(needle, query.caseSensitivity);
+
+    // the snapshot is read a window at a time instead of merging its pieces into one string, which would copy the
+    // whole document on every keystroke. a window starts one character early and ends one late so the whole word
+    // check can see whats on either side of a match
+    QString scratch;
+    qsizetype windowStart = 0;
+    auto window = [&](qsizetype from, qsizetype to){
+        windowStart = qMax<qsizetype>(0, from - 1);
+        return snapshot.view(windowStart, qMin(size, to + 1) - windowStart, &scratch);
+    };
+
+    QVector<qsizetype> positions; // every raw hit, becomes the cache if this search finishes
+    QVector<SearchMatch> batch;
+    qsizetype total = 0;
+    qsizetype nextAllowed = 0; // reported matches dont overlap, like repeated QTextDocument::find calls
+
+    // offset is where in the window the hit is
+    auto accept = [&](QStringView text, qsizetype offset){
+        const qsizetype index = windowStart + offset;
+        positions.append(index);
+        if(index >= nextAllowed && (!query.wholeWords || SearchKernel::isWholeWord(text, offset, needleLength))){
+            batch.append(SearchMatch{index, needleLength});
+            nextAllowed = index + needleLength;
+            total++;
+        }
+    };
+    auto flush = [&]{
+        if(batch.isEmpty()) return;
+        emit matchesFound(generation, batch);
+        batch.clear();
+    };
+
+    // a longer query can only match where the shorter one did, so only those spots need checking
+    const bool narrowing = cacheValid && revision == cachedRevision
+                           && query.caseSensitivity == cachedCaseSensitivity
+                           && needle.startsWith(cachedText, query.caseSensitivity);
+
+    if(narrowing){
+        for(qsizetype i = 0; i < cachedPositions.size(); ++i){
+            if(i % narrowBatchSize == 0){
+                flush();
+                if(cancelled(generation)) return;
+            }
+            const qsizetype index = cachedPositions.at(i);
+            if(index + needleLength > size) continue;
+
+            const QStringView text = window(index, index + needleLength);
+            if(kernel.matchesAt(text, index - windowStart)) accept(text, index - windowStart);
+        }
+        flush();
+    }
+    else{
+        for(qsizetype from = 0; from < size; ){
+            if(cancelled(generation)) return;
+
+            // a match has to start inside this chunk, but is allowed to run past the end of it
+            const qsizetype chunkEnd = qMin(from + chunkSize, size);
+            const QStringView text = window(from, qMin(size, chunkEnd + needleLength - 1));
+            const qsizetype lastStart = chunkEnd - windowStart; // the extra character at the end isnt a place to start
+
+            for(qsizetype offset = kernel.indexIn(text, from - windowStart); offset != -1 && offset < lastStart;
+                 offset = kernel.indexIn(text, offset + 1)){
+                accept(text, offset);
+            }
+            flush();
+            from = chunkEnd;
+        }
+    }
+
+    cacheValid = true;
+    cachedRevision = revision;
+    cachedText = query.text;
+    cachedCaseSensitivity = query.caseSensitivity;
+    cachedPositions = std::move(positions);
+
+    emit searchFinished(generation, total);
+}
+
+QRegularExpression SearchWorker::compile(const SearchQuery& query)
+{
+    // ^ and $ work per line like every other editor
+    QRegularExpression::PatternOptions options = QRegularExpression::MultilineOption | QRegularExpression::UseUnicodePropertiesOption;
+    if(query.caseSensitivity == Qt::CaseInsensitive) options |= QRegularExpression::CaseInsensitiveOption;
+    return QRegularExpression(query.text, options);
+}
+
+void SearchWorker::searchRegularExpression(quint64 generation, const TextBuffer& snapshot, const SearchQuery& query)
+{
+    const QRegularExpression regex = compile(query);
+    if(!regex.isValid()){
+        emit invalidPattern(generation, regex.errorString());
+        return;
+    }
+
+    const QString subject = snapshot.toString();
+    QVector<SearchMatch> batch;
+    qsizetype total = 0;
+
+    const bool finished = forEachRegexMatch(regex, subject, query.wholeWords, [&]{ return cancelled(generation); },
+                                            [&](const QRegularExpressionMatch& match){
+        batch.append(SearchMatch{match.capturedStart(), match.capturedLength()});
+        total++;
+        if(batch.size() == regexBatchSize){
+            emit matchesFound(generation, batch);
+            batch.clear();
+        }
+    });
+    if(!finished) return;
+
+    if(!batch.isEmpty()) emit matchesFound(generation, batch);
+    emit searchFinished(generation, total);
+}
+
+void SearchWorker::replaceAll(quint64 generation, quint64 revision, TextBuffer snapshot, const SearchQuery& query,
+                              const QString& replacement, const QVector<SearchMatch>& matches)
+{
+    if(cancelled(generation)) return;
+
+    QString rebuilt;
+    qsizetype spanStart = -1;
+    qsizetype copiedUpTo = 0;
+    qsizetype count = 0;
+
+    // copies the untouched text since the last match, then the replacement
+    auto replace = [&](qsizetype start, qsizetype length, QStringView with){
+        if(spanStart == -1) spanStart = copiedUpTo = start;
+        snapshot.forEachChunk(copiedUpTo, start - copiedUpTo, [&rebuilt](QStringView chunk){
+            rebuilt.append(chunk);
+        });
+        rebuilt.append(with);
+        copiedUpTo = start + length;
+        count++;
+    };
+
+    if(query.regularExpression){
+        const QRegularExpression regex = compile(query);
+        if(!regex.isValid()){
+            emit invalidPattern(generation, regex.errorString());
+            return;
+        }
+
+        const QString subject = snapshot.toString();
+        const bool finished = forEachRegexMatch(regex, subject, query.wholeWords, [&]{ return cancelled(generation); },
+                                                [&](const QRegularExpressionMatch& match){
+            replace(match.capturedStart(), match.capturedLength(), expandReplacement(replacement, match));
+        });
+        if(!finished) return;
+    }
+    else if(!matches.isEmpty()){
+        const qsizetype spanLength = matches.last().start + matches.last().length - matches.first().start;
+        rebuilt.reserve(spanLength + matches.size() * (replacement.size() - matches.first().length));
+
+        for(qsizetype i = 0; i < matches.size(); ++i){
+            if(i % narrowBatchSize == 0 && cancelled(generation)) return;
+            replace(matches.at(i).start, matches.at(i).length, replacement);
+        }
+    }
+
+    if(count == 0) spanStart = 0;
+    emit replaceAllReady(generation, revision, SearchReplacement{spanStart, copiedUpTo - spanStart, rebuilt}, count);
+}
+
+QString SearchWorker::expandReplacement(QStringView replacement, const QRegularExpressionMatch& match)
+{
+    auto isDigit = [](QChar c){ return c >= u'0' && c <= u'9'; };
+
+    QString result;
+    result.reserve(replacement.size());
+    for(qsizetype i = 0; i < replacement.size(); ++i){
+        const QChar c = replacement.at(i);
+        if(c != u'\\' || i + 1 == replacement.size()){
+            result.append(c);
+            continue;
+        }
+
+        const QChar next = replacement.at(i + 1);
+        if(isDigit(next)){
+            int group = next.unicode() - u'0';
+            i++;
+            // a second digit only belongs to the reference if the expression has that many groups
+            if(i + 1 < replacement.size() && isDigit(replacement.at(i + 1))){
+                const int twoDigits = group * 10 + (replacement.at(i + 1).unicode() - u'0');
+                if(twoDigits <= match.regularExpression().captureCount()){
+                    group = twoDigits;
+                    i++;
+                }
+            }
+            result.append(match.captured(group));
+        }
+        else if(next == u'n'){
+            result.append(u'\n');
+            i++;
+        }
+        else if(next == u't'){
+            result.append(u'\t');
+            i++;
+        }
+        else if(next == u'\\'){
+            result.append(u'\\');
+            i++;
+        }
+        else{
+            result.append(c);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,88 @@
+#ifndef SEARCHWORKER_H
+#define SEARCHWORKER_H
+
+#include <QObject>
+#include <QMetaType>
+#include <QRegularExpression>
+#include <atomic>
+#include "textbuffer.h"
+
+struct SearchMatch
+{
+    qsizetype start;
+    qsizetype length;
+};
+Q_DECLARE_METATYPE(SearchMatch)
+
+// a range of the document and the text it gets replaced with
+struct SearchReplacement
+{
+    qsizetype start;
+    qsizetype length;
+    QString text;
+};
+Q_DECLARE_METATYPE(SearchReplacement)
+
+struct SearchQuery
+{
+    QString text;
+    Qt::CaseSensitivity caseSensitivity = Qt::CaseInsensitive;
+    bool wholeWords = false;
+    bool regularExpression = false;
+};
+
+// finds every occurrence of a query in a document snapshot, lives on SearchAndReplace's worker thread
+// matches are sent back a chunk at a time, and a search stops as soon as a newer one is started.
+// the raw hits of the last finished search are kept, so typing more characters onto the same query
+// only re-checks those positions instead of scanning the document again
+class SearchWorker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SearchWorker(const std::atomic<quint64>* latestGeneration);
+
+    // revision identifies the documents text, the cached hits are only reused for the same revision
+    void search(quint64 generation, quint64 revision, TextBuffer snapshot, const SearchQuery& query);
+
+    // builds the text from the first match to the end of the last one with every match replaced, in one pass,
+    // so the gui can swap it in with a single edit. literal queries use the matches the search already found,
+    // regular expressions are matched again since \1 style references need the capture groups
+    // revision is sent back with the result so the gui can tell if the text changed in the meantime
+    void replaceAll(quint64 generation, quint64 revision, TextBuffer snapshot, const SearchQuery& query, const QString& replacement,
+                    const QVector<SearchMatch>& matches);
+
+    // \0 to \99 become capture groups, \n and \t a newline and tab, \\ a backslash, anything else is copied as is
+    static QString expandReplacement(QStringView replacement, const QRegularExpressionMatch& match);
+
+signals:
+    void matchesFound(quint64 generation, const QVector<SearchMatch>& matches);
+    void searchFinished(quint64 generation, qsizetype total);
+    // span is everything from the first replaced match to the end of the last, count is how many were replaced
+    void replaceAllReady(quint64 generation, quint64 revision, const SearchReplacement& span, qsizetype count);
+    void invalidPattern(quint64 generation, const QString& message);
+
+private:
+    inline bool cancelled(quint64 generation) const
+    {
+        return latestGeneration->load(std::memory_order_relaxed) != generation;
+    }
+
+    void searchRegularExpression(quint64 generation, const TextBuffer& snapshot, const SearchQuery& query);
+    static QRegularExpression compile(const SearchQuery& query);
+
+private:
+    inline static constexpr qsizetype chunkSize = 1024 * 1024; // characters scanned between checks for a newer search
+    inline static constexpr qsizetype narrowBatchSize = 64 * 1024; // cached hits re-checked between checks
+    inline static constexpr qsizetype regexBatchSize = 4096; // regex matches sent back at a time
+
+    const std::atomic<quint64>* latestGeneration; // owned by SearchAndReplace, which outlives the thread
+
+    // every hit (overlapping ones too, ignoring whole word) of the last search that finished
+    bool cacheValid = false;
+    quint64 cachedRevision = 0;
+    QString cachedText;
+    Qt::CaseSensitivity cachedCaseSensitivity = Qt::CaseInsensitive;
+    QVector<qsizetype> cachedPositions;
+};
+
+#endif // SEARCHWORKER_H
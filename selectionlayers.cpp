@@ -0,0 +1,30 @@
+#include "selectionlayers.h"
+
+SelectionLayers::SelectionLayers(QPlainTextEdit* textEdit) :
+    textEdit(textEdit)
+{
+}
+
+void SelectionLayers::set(Layer layer, const QList<QTextEdit::ExtraSelection>& selections)
+{
+    layers[layer] = selections;
+    apply();
+}
+
+void SelectionLayers::clear(Layer layer)
+{
+    if(layers[layer].isEmpty()) return;
+    layers[layer].clear();
+    apply();
+}
+
+void SelectionLayers::apply()
+{
+    qsizetype total = 0;
+    for(const auto& layer : layers) total += layer.size();
+
+    QList<QTextEdit::ExtraSelection> combined;
+    combined.reserve(total);
+    for(const auto& layer : layers) combined.append(layer);
+    textEdit->setExtraSelections(combined);
+}
@@ -0,0 +1,32 @@
+#ifndef SELECTIONLAYERS_H
+#define SELECTIONLAYERS_H
+
+#include <QPlainTextEdit>
+#include <array>
+
+// a QPlainTextEdit only has one list of extra selections, setting it replaces whatever was there
+// search highlights and the multi cursor selections each keep their own layer here, and the text edit gets
+// all of them put together, so one updating doesnt wipe out the other
+class SelectionLayers
+{
+public:
+    enum Layer{
+        SearchMatches,
+        CursorSelections, // after the search matches, drawn on top of them
+        LayerCount
+    };
+
+    explicit SelectionLayers(QPlainTextEdit* textEdit);
+
+    void set(Layer layer, const QList<QTextEdit::ExtraSelection>& selections);
+    void clear(Layer layer);
+
+private:
+    void apply();
+
+private:
+    QPlainTextEdit* textEdit; // non-owning
+    std::array<QList<QTextEdit::ExtraSelection>, LayerCount> layers;
+};
+
+#endif // SELECTIONLAYERS_H
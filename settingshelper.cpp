@@ -1 +1,71 @@
 #include "settingshelper.h"
+
+autoSaveType SettingsHelper::autoSave() const
+{
+    // stored as the enum's int value, anything out of range (older or hand edited settings) means off
+    const int value = settings.value(autoSaveKey, static_cast<int>(autoSaveType::NeverAutoSave)).toInt();
+    if(value < static_cast<int>(autoSaveType::NeverAutoSave) || value > static_cast<int>(autoSaveType::SaveAfterDuratoion)){
+        return autoSaveType::NeverAutoSave;
+    }
+    return static_cast<autoSaveType>(value);
+}
+
+void SettingsHelper::setAutoSave(autoSaveType type)
+{
+    settings.setValue(autoSaveKey, static_cast<int>(type));
+}
+
+int SettingsHelper::autoSaveDelay() const
+{
+    const int delay = settings.value(autoSaveDelayKey, defaultAutoSaveDelay).toInt();
+    return delay > 0 ? delay : defaultAutoSaveDelay;
+}
+
+void SettingsHelper::setAutoSaveDelay(int milliseconds)
+{
+    settings.setValue(autoSaveDelayKey, milliseconds);
+}
+
+int SettingsHelper::terminalScrollback() const
+{
+    const int lines = settings.value(terminalScrollbackKey, defaultTerminalScrollback).toInt();
+    return lines > 0 ? lines : defaultTerminalScrollback;
+}
+
+void SettingsHelper::setTerminalScrollback(int lines)
+{
+    settings.setValue(terminalScrollbackKey, lines);
+}
+
+int SettingsHelper::tabMemoryBudget() const
+{
+    const int megabytes = settings.value(tabMemoryBudgetKey, defaultTabMemoryBudget).toInt();
+    return megabytes > 0 ? megabytes : defaultTabMemoryBudget;
+}
+
+void SettingsHelper::setTabMemoryBudget(int megabytes)
+{
+    settings.setValue(tabMemoryBudgetKey, megabytes);
+}
+
+QStringList SettingsHelper::sessionFiles() const
+{
+    return settings.value(sessionFilesKey).toStringList();
+}
+
+QString SettingsHelper::sessionCurrentFile() const
+{
+    return settings.value(sessionCurrentFileKey).toString();
+}
+
+QString SettingsHelper::sessionFolder() const
+{
+    return settings.value(sessionFolderKey).toString();
+}
+
+void SettingsHelper::setSession(const QStringList& files, const QString& currentFile, const QString& folder)
+{
+    settings.setValue(sessionFilesKey, files);
+    settings.setValue(sessionCurrentFileKey, currentFile);
+    settings.setValue(sessionFolderKey, folder);
+}
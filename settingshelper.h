@@ -13,9 +13,38 @@ Q_DECLARE_METATYPE(autoSaveType)
 class SettingsHelper
 {
 public:
-    SettingsHelper() = delete;
+    SettingsHelper() = default;
+
+    autoSaveType autoSave() const;
+    void setAutoSave(autoSaveType type);
+
+    int autoSaveDelay() const; // milliseconds after the last edit before SaveAfterDuratoion saves
+    void setAutoSaveDelay(int milliseconds);
+
+    int terminalScrollback() const; // lines the terminal box keeps before dropping the oldest
+    void setTerminalScrollback(int lines);
+
+    int tabMemoryBudget() const; // megabytes the open editors can use before the least recently shown get evicted
+    void setTabMemoryBudget(int megabytes);
+
+    // the tabs and folder open when the editor last closed, reopened on the next start
+    QStringList sessionFiles() const;
+    QString sessionCurrentFile() const;
+    QString sessionFolder() const;
+    void setSession(const QStringList& files, const QString& currentFile, const QString& folder);
+
 public: // Object representations of the string value keys
+    inline static const QString autoSaveKey{"autoSave/type"};
+    inline static const QString autoSaveDelayKey{"autoSave/delay"};
+    inline static const QString terminalScrollbackKey{"terminal/scrollback"};
+    inline static const QString tabMemoryBudgetKey{"editor/tabMemoryBudget"};
+    inline static const QString sessionFilesKey{"session/files"};
+    inline static const QString sessionCurrentFileKey{"session/currentFile"};
+    inline static const QString sessionFolderKey{"session/folder"};
 
+    inline static constexpr int defaultAutoSaveDelay = 2000;
+    inline static constexpr int defaultTerminalScrollback = 10000;
+    inline static constexpr int defaultTabMemoryBudget = 256;
 
 private:
     QSettings settings{"Murad", "notepad"}; // thats the name for now i guess..
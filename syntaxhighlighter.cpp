@@ -1,92 +1,211 @@
 #include "syntaxhighlighter.h"
 #include <QTextBlock>
 #include <QTextCursor>
-SyntaxHighlighter::SyntaxHighlighter(QTextDocument* parent) :
-    QSyntaxHighlighter(parent)
-{
-
-    HighlightingRule rule;
+#include <QTimer>
+#include <QScrollBar>
 
+SyntaxHighlighter::SyntaxHighlighter(QPlainTextEdit* textEdit, const TextBuffer* buffer) :
+    QObject(textEdit),
+    textEdit(textEdit),
+    buffer(buffer)
+{
     keywordFormat.setForeground(keywordColor);
-    addRule(keywordsRegex, keywordFormat);
+    keywordFormat.setFontWeight(QFont::Bold);
 
     functionFormat.setForeground(functionColor);
-    addRule(functionRegex, functionFormat);
+    functionFormat.setFontWeight(QFont::Bold);
 
     classFormat.setForeground(classColor);
-    addRule(classRegex, classFormat);
+    classFormat.setFontWeight(QFont::Bold);
 
-    singleLineStringFormat.setForeground(stringColor);
-    addRule(singleLineStringRegex, singleLineStringFormat);
+    stringFormat.setForeground(stringColor);
+    stringFormat.setFontWeight(QFont::Bold);
 
     commentFormat.setForeground(commentColor);
-    // addRule(commentRegex, commentFormat);
-    // highlightingRules.emplace_back(commentRegex, commentFormat);
+
+    lastBlockCount = textEdit->document()->blockCount();
+
+    connect(textEdit->document(), &QTextDocument::contentsChange, this, &SyntaxHighlighter::documentChanged);
+    // scrolling to blocks that arent done yet bumps them to the front
+    connect(textEdit->verticalScrollBar(), &QScrollBar::valueChanged, this, &SyntaxHighlighter::scheduleDispatch);
 }
 
-// manual comment detection to avoid errors with comments embedded in strings and vice versa
-void SyntaxHighlighter::highlightBlock(const QString &text)
+SyntaxHighlighter::~SyntaxHighlighter()
 {
+    if(worker != nullptr){
+        workerThread.quit();
+        workerThread.wait(); // at most one batch of lines to finish
+    }
+}
 
-    int commentStart = -1;
-    bool inString = false;
-    QChar stringChar;
-    bool escape = false;
+const QTextCharFormat& SyntaxHighlighter::formatFor(PythonToken token) const
+{
+    switch(token){
+    case PythonToken::Keyword: return keywordFormat;
+    case PythonToken::Function: return functionFormat;
+    case PythonToken::Class: return classFormat;
+    case PythonToken::String: return stringFormat;
+    case PythonToken::Comment: break;
+    }
+    return commentFormat;
+}
 
-    for (int i = 0; i < text.length(); ++i){
-        QChar c = text[i];
+void SyntaxHighlighter::documentChanged(int from, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
 
-        if (inString){
-            if (escape){
-                escape = false;
-            }
-            else if (c == '\\') {
-                escape = true;
-            }
-            else if (c == stringChar){
-                inString = false;
-            }
-        }
-        else{
+    QTextDocument* document = textEdit->document();
+    const int firstBlock = document->findBlock(from).blockNumber();
+    const QTextBlock lastChanged = document->findBlock(from + charsAdded);
+    const int lastBlock = lastChanged.isValid() ? lastChanged.blockNumber() : document->blockCount() - 1;
 
-            if (c == '"' || c == '\''){
-                inString = true;
-                stringChar = c;
-            }
-            else if (c == '#'){
-                commentStart = i;
-                break;
-            }
+    const int blockDelta = document->blockCount() - lastBlockCount;
+    lastBlockCount = document->blockCount();
+
+    // everything after the edit moved by however many lines were added or removed
+    if(resumeAt > firstBlock) resumeAt = qMax(resumeAt + blockDelta, lastBlock + 1);
+    if(dirtyEnd > firstBlock) dirtyEnd = qMax(dirtyEnd + blockDelta, lastBlock + 1);
+
+    if(verifiedUpTo > firstBlock){
+        // the blocks after the edit still have their old states, if the pass gets back to matching states it can skip them
+        resumeAt = qMax(resumeAt, qMax(verifiedUpTo + blockDelta, lastBlock + 1));
+        verifiedUpTo = qMax(firstBlock, 0);
+    }
+    dirtyEnd = qMax(dirtyEnd, lastBlock + 1);
+
+    for(Request& pending : requests){
+        pending.editedFrom = qMin(pending.editedFrom, firstBlock);
+    }
+    speculatedLast = -1; // the guess for the visible blocks might be off now
+
+    scheduleDispatch();
+}
+
+void SyntaxHighlighter::scheduleDispatch()
+{
+    if(dispatchPending) return;
+    dispatchPending = true;
+    QTimer::singleShot(0, this, &SyntaxHighlighter::dispatch);
+}
+
+void SyntaxHighlighter::dispatch()
+{
+    dispatchPending = false;
+    QTextDocument* document = textEdit->document();
+
+    if(buffer->size() != document->characterCount() - 1){
+        return; // the buffer catches up on its own, the next change schedules this again
+    }
+
+    // visible blocks the top to bottom pass hasnt reached yet, lexed with the best guess for the state going in
+    if(!requests[VisibleRequest].inFlight){
+        const int firstVisible = textEdit->cursorForPosition(QPoint(0, 0)).blockNumber();
+        const int lastVisible = textEdit->cursorForPosition(QPoint(0, textEdit->viewport()->height() - 1)).blockNumber();
+        const int first = qMax(firstVisible, verifiedUpTo);
+
+        const bool alreadyGuessed = first >= speculatedFirst && lastVisible <= speculatedLast;
+        if(first <= lastVisible && !alreadyGuessed){
+            const int startState = first > 0 ? qMax(document->findBlockByNumber(first - 1).userState(), 0) : -1;
+            speculatedFirst = first;
+            speculatedLast = lastVisible;
+            request(VisibleRequest, first, lastVisible, startState);
         }
     }
 
-    QVector<QPair<int, int>> protectedRanges;
+    // the next batch of the pass that fills in (and verifies) the whole document
+    if(!requests[ChainRequest].inFlight && verifiedUpTo < document->blockCount()){
+        const int last = qMin(verifiedUpTo + chainBatchSize, document->blockCount()) - 1;
+        const int startState = verifiedUpTo > 0 ? document->findBlockByNumber(verifiedUpTo - 1).userState() : -1;
+        request(ChainRequest, verifiedUpTo, last, startState);
+    }
+}
 
-    if (commentStart >= 0){
-        int length = text.length() - commentStart;
-        setFormat(commentStart, length, commentFormat); // apply the formatting to the comment
-        protectedRanges.append(qMakePair(commentStart, text.length()));
+void SyntaxHighlighter::request(RequestSlot slot, int firstBlock, int lastBlock, int startState)
+{
+    QTextDocument* document = textEdit->document();
+    const QTextBlock first = document->findBlockByNumber(firstBlock);
+    const QTextBlock last = document->findBlockByNumber(lastBlock);
+    const qsizetype position = first.position();
+    const qsizetype length = last.position() + last.length() - 1 - position; // without the last blocks separator
+
+    if(worker == nullptr){
+        worker = new HighlightWorker;
+        worker->moveToThread(&workerThread);
+        connect(&workerThread, &QThread::finished, worker, &QObject::deleteLater);
+        connect(worker, &HighlightWorker::tokenized, this, &SyntaxHighlighter::applyResults);
+        workerThread.start();
     }
 
-    // then go back to applying the regular rules
-    for (const HighlightingRule &rule : std::as_const(highlightingRules)){
-        QRegularExpressionMatchIterator matchIterator = rule.pattern.globalMatch(text);
-        while (matchIterator.hasNext()) {
-            QRegularExpressionMatch match = matchIterator.next();
-            int start = match.capturedStart();
-            int length = match.capturedLength();
-
-            bool overlaps = false;
-            for (const auto& range : protectedRanges) {
-                if (start < range.second && (start + length) > range.first) {
-                    overlaps = true; // skip the match if its within a comment already (dont apply highlighting on it)
-                    break;
-                }
-            }
-            if(!overlaps){
-                setFormat(start, length, rule.format);
+    requests[slot] = Request{true, firstBlock, lastBlock, INT_MAX};
+
+    // copying the buffer is what makes the snapshot, the worker never sees the live one
+    QMetaObject::invokeMethod(worker, [worker = worker, slot, snapshot = *buffer, position, length, startState]{
+        worker->tokenize(slot, snapshot, position, length, startState);
+    }, Qt::QueuedConnection);
+}
+
+void SyntaxHighlighter::applyResults(int slot, const QVector<HighlightedBlock>& blocks)
+{
+    Request& finished = requests[slot];
+    finished.inFlight = false;
+
+    // an edit at or above the last block means the line numbers (or text) the worker used are stale
+    const bool stillValid = finished.editedFrom > finished.lastBlock
+                            && blocks.size() == finished.lastBlock - finished.firstBlock + 1;
+    if(!stillValid){
+        if(slot == VisibleRequest) speculatedLast = -1;
+        scheduleDispatch();
+        return;
+    }
+
+    QTextDocument* document = textEdit->document();
+    QTextBlock block = document->findBlockByNumber(finished.firstBlock);
+    int dirtyFrom = -1, dirtyTo = -1;
+    bool converged = false;
+
+    for(int i = 0; i < blocks.size() && block.isValid(); ++i, block = block.next()){
+        if(applyFormats(block, blocks[i].runs)){
+            if(dirtyFrom == -1) dirtyFrom = block.position();
+            dirtyTo = block.position() + block.length();
+        }
+
+        if(slot == ChainRequest){
+            const int blockNumber = finished.firstBlock + i;
+            if(blockNumber >= dirtyEnd && blockNumber < resumeAt && block.userState() == blocks[i].endState){
+                converged = true; // same state as before the edit, so the blocks up to resumeAt come out the same too
             }
+            block.setUserState(blocks[i].endState);
         }
     }
+
+    // one relayout for the whole batch instead of one per block
+    if(dirtyFrom != -1) document->markContentsDirty(dirtyFrom, dirtyTo - dirtyFrom);
+
+    if(slot == ChainRequest){
+        verifiedUpTo = finished.lastBlock + 1;
+        if(converged) verifiedUpTo = qMax(verifiedUpTo, resumeAt);
+        if(verifiedUpTo >= resumeAt) resumeAt = 0;
+        if(verifiedUpTo >= dirtyEnd) dirtyEnd = 0;
+    }
+
+    scheduleDispatch();
 }
 
+bool SyntaxHighlighter::applyFormats(QTextBlock& block, const QVector<TokenRun>& runs)
+{
+    QList<QTextLayout::FormatRange> ranges;
+    ranges.reserve(runs.size());
+    for(const TokenRun& run : runs){
+        QTextLayout::FormatRange range;
+        range.start = run.start;
+        range.length = run.length;
+        range.format = formatFor(run.token);
+        ranges.append(range);
+    }
+
+    QTextLayout* layout = block.layout();
+    if(layout->formats() == ranges) return false;
+
+    layout->setFormats(ranges);
+    return true;
+}
@@ -1,19 +1,26 @@
 #ifndef SYNTAXHIGHLIGHTER_H
 #define SYNTAXHIGHLIGHTER_H
 
-#include <QStringView>
-#include <QRegularExpression>
 #include <QColor>
-#include <QSyntaxHighlighter>
 #include <QPlainTextEdit>
+#include <QTextLayout>
+#include <QThread>
+#include <climits>
+#include "pythonlexer.h"
+#include "highlightworker.h"
+#include "textbuffer.h"
 
-// its now gonna follow an approach pretty similar to qt's example implementation on their docs
-class SyntaxHighlighter : public QSyntaxHighlighter
+// highlights the document from a worker thread, PythonLexer runs on a snapshot of the text and only
+// applying the formats happens on the gui thread. the blocks on screen get done first (with a guessed
+// starting state if the lines above arent done yet), then the rest is filled in top to bottom in batches
+// whenever the event loop is idle. block states are kept in QTextBlock::userState like QSyntaxHighlighter
+// does, so after an edit the top to bottom pass stops as soon as a blocks state matches what it was before
+class SyntaxHighlighter : public QObject
 {
 public:
-    SyntaxHighlighter(QTextDocument* parent);
-protected:
-    void highlightBlock(const QString& text) override;
+    SyntaxHighlighter(QPlainTextEdit* textEdit, const TextBuffer* buffer);
+    ~SyntaxHighlighter();
+
 public:
     // switch to file later on to allow it to change (themes...)
     inline static QColor commentColor{22, 120, 13};
@@ -21,55 +28,53 @@ public:
     inline static QColor keywordColor{28, 76, 189};
     inline static QColor classColor{186, 194, 31};
     inline static QColor functionColor{145, 20, 47};
+
 private:
+    enum RequestSlot {
+        VisibleRequest, // the blocks on screen, formats only
+        ChainRequest, // the next batch of the top to bottom pass, formats and states
+        RequestSlotCount
+    };
 
-    struct HighlightingRule
+    struct Request
     {
-        QRegularExpression pattern;
-        QTextCharFormat format;
+        bool inFlight = false;
+        int firstBlock = 0;
+        int lastBlock = 0;
+        int editedFrom = INT_MAX; // lowest block edited since the request went out
     };
 
-    inline void addRule(const QRegularExpression& regexp,  QTextCharFormat& format, bool bold = true){
-        if(bold) format.setFontWeight(QFont::Bold);
-        HighlightingRule rule{regexp, format};
-
-        highlightingRules.append(rule);
-    }
-
-    inline bool isOverlapping(int start, int length, const QVector<QPair<int, int>> &ranges) const
-    {
-        int end = start + length;
-        for (const auto &range : ranges) {
-            int rangeStart = range.first;
-            int rangeEnd = range.second;
-            if (start < rangeEnd && end > rangeStart) {
-                return true;
-            }
-        }
-        return false;
-    }
+    void documentChanged(int from, int charsRemoved, int charsAdded);
+    void scheduleDispatch();
+    void dispatch(); // sends off whatever work is next, visible blocks first
+    void request(RequestSlot slot, int firstBlock, int lastBlock, int startState);
+    void applyResults(int slot, const QVector<HighlightedBlock>& blocks);
+    bool applyFormats(QTextBlock& block, const QVector<TokenRun>& runs); // true if the formats changed
+    const QTextCharFormat& formatFor(PythonToken token) const;
 
 private:
-    QTextCharFormat keywordFormat;
-    const inline static QRegularExpression keywordsRegex{R"(\b(def|class|if|else|elif|return|import|from|while|for|in|try|except|with|as|pass|yield|async|await|None|True|False)\b)"};
+    inline static constexpr int chainBatchSize = 2000; // lines per batch of the top to bottom pass
 
-    QTextCharFormat functionFormat;
-    const inline static QRegularExpression functionRegex{R"(\bdef\s+([a-zA-Z_][a-zA-Z0-9_]*)\b)"};
+    QPlainTextEdit* textEdit; // non-owning
+    const TextBuffer* buffer; // the editors piece table, snapshots of it are what the worker reads
 
-    QTextCharFormat classFormat;
-    // const inline static QRegularExpression classRegex{R"(\bclass\s+([a-zA-Z_][a-zA9_]*)\b)"};
-    const inline static QRegularExpression classRegex{R"(\bclass\s+([a-zA-Z_][a-zA-Z0-9_]*)\b)"};
+    QThread workerThread;
+    HighlightWorker* worker = nullptr; // created the first time theres something to highlight
 
+    Request requests[RequestSlotCount];
+    bool dispatchPending = false;
 
-    // QTextCharFormat multiLineStringFormat; // disregarding for now
-    QTextCharFormat singleLineStringFormat;
-    const inline static QRegularExpression singleLineStringRegex{R"(\".*\")"};
+    int verifiedUpTo = 0; // blocks before this have states (and formats) worked out from the top of the file
+    int resumeAt = 0; // blocks before this were verified before the last edit, the pass can jump here once states match
+    int dirtyEnd = 0; // blocks from here on werent touched by edits, so a matching state there means nothing after changed
+    int speculatedFirst = 0, speculatedLast = -1; // the visible range the worker already guessed formats for
+    int lastBlockCount = 1;
 
+    QTextCharFormat keywordFormat;
+    QTextCharFormat functionFormat;
+    QTextCharFormat classFormat;
+    QTextCharFormat stringFormat;
     QTextCharFormat commentFormat;
-    const inline static QRegularExpression commentRegex{R"(#[^\n]*)"};
-
-
-    QList<HighlightingRule> highlightingRules;
 };
 
 #endif // SYNTAXHIGHLIGHTER_H
@@ -0,0 +1,41 @@
+#include "tabplaceholder.h"
+
+TabPlaceholder::TabPlaceholder(const QString& filePath, QWidget* parent) :
+    QLabel(parent),
+    filePath(filePath)
+{
+    setAlignment(Qt::AlignCenter);
+}
+
+void TabPlaceholder::showOpenError(const QString& error)
+{
+    setText(tr("Can Not Open File ") + filePath + "\n" + error);
+}
+
+void TabPlaceholder::setEvictedState(const editor::ViewState& state)
+{
+    evictedViewState = state;
+    unsaved = false;
+    compressedText.clear();
+}
+
+void TabPlaceholder::setEvictedState(const editor::ViewState& state, const QString& unsavedText)
+{
+    evictedViewState = state;
+    unsaved = true;
+    compressedText = qCompress(unsavedText.toUtf8());
+}
+
+QString TabPlaceholder::unsavedText() const
+{
+    return QString::fromUtf8(qUncompress(compressedText));
+}
+
+void TabPlaceholder::askToSaveUnsavedText(QWidget* dialogParent)
+{
+    if(!unsaved) return;
+
+    editor::saveOrDiscardText(dialogParent, filePath, unsavedText());
+    unsaved = false;
+    compressedText.clear();
+}
@@ -0,0 +1,48 @@
+#ifndef TABPLACEHOLDER_H
+#define TABPLACEHOLDER_H
+
+#include <QLabel>
+#include <optional>
+#include "editor.h"
+
+// stands in for an editor in a tab that hasnt been looked at yet, just the file path and nothing read from it
+// a restored session can have dozens of tabs, only the one showing needs a whole editor with its document,
+// highlighter and search dock. MainWindow swaps this for the real editor the first time its tab becomes current.
+// an editor evicted to save memory is swapped back for one of these, keeping where it was scrolled to and, if it
+// had unsaved changes, its text compressed
+class TabPlaceholder : public QLabel
+{
+    Q_OBJECT // no signals, but MainWindow tells it apart from an editor with qobject_cast
+public:
+    TabPlaceholder(const QString& filePath, QWidget* parent);
+
+    inline QString fileName() const
+    {
+        return filePath;
+    }
+
+    void showOpenError(const QString& error); // the file couldnt be read when the tab was shown
+
+    void setEvictedState(const editor::ViewState& state); // a clean editor, the file on disk has its text
+    void setEvictedState(const editor::ViewState& state, const QString& unsavedText);
+    inline const std::optional<editor::ViewState>& viewState() const
+    {
+        return evictedViewState;
+    }
+    inline bool hasUnsavedText() const
+    {
+        return unsaved;
+    }
+    QString unsavedText() const;
+    // closing the tab, asks to save the unsaved text the same way an editor does. answered from the kept text
+    // rather than loading the file back, a large file would still be streaming in and its editor couldnt ask
+    void askToSaveUnsavedText(QWidget* dialogParent);
+
+private:
+    QString filePath;
+    std::optional<editor::ViewState> evictedViewState; // only set for an evicted editor
+    bool unsaved = false;
+    QByteArray compressedText; // utf-8 run through qCompress, source code usually shrinks to a fraction
+};
+
+#endif // TABPLACEHOLDER_H
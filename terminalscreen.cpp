@@ -0,0 +1,417 @@
+#include "terminalscreen.h"
+#include <utility>
+
+TerminalScreen::TerminalScreen(int columns, int rows, int scrollbackLimit) :
+    columnCount(qMax(columns, 1)),
+    rowCount(qMax(rows, 1)),
+    historyLimit(qMax(scrollbackLimit, 0))
+{
+    reset();
+}
+
+const TerminalLine& TerminalScreen::line(qsizetype index) const
+{
+    if(index < historySize()) return history[size_t(index)];
+    return grid.at(index - historySize());
+}
+
+void TerminalScreen::setScrollbackLimit(int lines)
+{
+    historyLimit = qMax(lines, 0);
+    while(historySize() > historyLimit){
+        history.pop_front();
+        damage.droppedFromHistory++;
+    }
+}
+
+void TerminalScreen::reset()
+{
+    alternate = false;
+    mainGrid.clear();
+    cursor = Cursor();
+    savedCursor = Cursor();
+    scrollTop = 0;
+    scrollBottom = rowCount - 1;
+    autoWrap = true;
+    showCursor = true;
+
+    grid = QVector<TerminalLine>(rowCount, blankLine());
+    damageAll();
+}
+
+void TerminalScreen::clearAll()
+{
+    damage.droppedFromHistory += historySize();
+    history.clear();
+    for(TerminalLine& row : grid) row = blankLine();
+    cursor.row = cursor.column = 0;
+    cursor.wrapPending = false;
+    damageAll();
+}
+
+TerminalScreen::Damage TerminalScreen::takeDamage()
+{
+    return std::exchange(damage, Damage());
+}
+
+TerminalLine TerminalScreen::blankLine() const
+{
+    TerminalLine line;
+    line.cells = QVector<TerminalCell>(columnCount, blankCell());
+    return line;
+}
+
+TerminalCell TerminalScreen::blankCell() const
+{
+    TerminalCell cell;
+    cell.style.background = cursor.style.background;
+    return cell;
+}
+
+void TerminalScreen::damageRows(int first, int last)
+{
+    damage.firstRow = qMin(damage.firstRow, qMax(first, 0));
+    damage.lastRow = qMax(damage.lastRow, qMin(last, rowCount - 1));
+}
+
+void TerminalScreen::damageAll()
+{
+    damage.all = true;
+    damageRows(0, rowCount - 1);
+}
+
+void TerminalScreen::pushToHistory(TerminalLine line)
+{
+    if(historyLimit == 0) return;
+
+    // trailing blanks are most of a typical line, no point keeping them around
+    qsizetype used = line.cells.size();
+    while(used > 0 && line.cells.at(used - 1).character == U' ' && line.cells.at(used - 1).style == TerminalStyle()) used--;
+    line.cells.resize(used);
+    line.cells.squeeze();
+
+    history.push_back(std::move(line));
+    if(historySize() > historyLimit){
+        history.pop_front();
+        damage.droppedFromHistory++;
+    }
+}
+
+void TerminalScreen::scrollRegionUp(int top, int bottom, int count)
+{
+    count = qMin(count, bottom - top + 1);
+    if(count <= 0) return;
+
+    const bool wholeScreen = top == 0 && bottom == rowCount - 1;
+    for(int i = 0; i < count; ++i){
+        TerminalLine scrolledOff = std::move(grid[top]);
+        grid.remove(top);
+        grid.insert(bottom, blankLine());
+        if(wholeScreen && !alternate) pushToHistory(std::move(scrolledOff));
+    }
+
+    if(wholeScreen && !damage.all){
+        // what was painted is still right, just higher up, so the widget can move it instead of repainting
+        damage.scrolled += count;
+        if(damage.lastRow >= 0){
+            damage.firstRow = qMax(damage.firstRow - count, 0);
+            damage.lastRow -= count;
+            if(damage.lastRow < 0){
+                damage.firstRow = INT_MAX;
+                damage.lastRow = -1;
+            }
+        }
+        if(damage.scrolled >= rowCount) damageAll();
+        damageRows(bottom - count + 1, bottom);
+    }
+    else{
+        damageRows(top, bottom);
+    }
+}
+
+void TerminalScreen::scrollRegionDown(int top, int bottom, int count)
+{
+    count = qMin(count, bottom - top + 1);
+    if(count <= 0) return;
+
+    for(int i = 0; i < count; ++i){
+        grid.remove(bottom);
+        grid.insert(top, blankLine());
+    }
+    damageRows(top, bottom);
+}
+
+void TerminalScreen::print(char32_t character)
+{
+    if(cursor.wrapPending){
+        cursor.wrapPending = false;
+        if(autoWrap){
+            grid[cursor.row].wrapped = true;
+            cursor.column = 0;
+            lineFeed();
+        }
+    }
+
+    TerminalCell& cell = grid[cursor.row].cells[cursor.column];
+    cell.character = character;
+    cell.style = cursor.style;
+    damageRows(cursor.row, cursor.row);
+
+    if(cursor.column == columnCount - 1) cursor.wrapPending = true;
+    else cursor.column++;
+}
+
+void TerminalScreen::carriageReturn()
+{
+    cursor.column = 0;
+    cursor.wrapPending = false;
+}
+
+void TerminalScreen::lineFeed()
+{
+    cursor.wrapPending = false;
+    if(cursor.row == scrollBottom) scrollRegionUp(scrollTop, scrollBottom, 1);
+    else if(cursor.row < rowCount - 1) cursor.row++;
+}
+
+void TerminalScreen::reverseIndex()
+{
+    cursor.wrapPending = false;
+    if(cursor.row == scrollTop) scrollRegionDown(scrollTop, scrollBottom, 1);
+    else if(cursor.row > 0) cursor.row--;
+}
+
+void TerminalScreen::backspace()
+{
+    cursor.wrapPending = false;
+    if(cursor.column > 0) cursor.column--;
+}
+
+void TerminalScreen::tab()
+{
+    cursor.wrapPending = false;
+    cursor.column = qMin((cursor.column / 8 + 1) * 8, columnCount - 1);
+}
+
+void TerminalScreen::moveCursor(int row, int column)
+{
+    cursor.row = qBound(0, row, rowCount - 1);
+    cursor.column = qBound(0, column, columnCount - 1);
+    cursor.wrapPending = false;
+}
+
+void TerminalScreen::moveCursorBy(int rows, int columns)
+{
+    // relative moves stop at the edge of the scroll region if they start inside it
+    int row = cursor.row + rows;
+    if(cursor.row >= scrollTop && cursor.row <= scrollBottom) row = qBound(scrollTop, row, scrollBottom);
+    moveCursor(row, cursor.column + columns);
+}
+
+void TerminalScreen::eraseInDisplay(int mode)
+{
+    switch(mode){
+    case 0:
+        eraseInLine(0);
+        for(int row = cursor.row + 1; row < rowCount; ++row) grid[row] = blankLine();
+        damageRows(cursor.row, rowCount - 1);
+        break;
+    case 1:
+        eraseInLine(1);
+        for(int row = 0; row < cursor.row; ++row) grid[row] = blankLine();
+        damageRows(0, cursor.row);
+        break;
+    case 3:
+        damage.droppedFromHistory += historySize();
+        history.clear();
+        damageAll();
+        Q_FALLTHROUGH();
+    case 2:
+        for(TerminalLine& row : grid) row = blankLine();
+        damageRows(0, rowCount - 1);
+        break;
+    }
+}
+
+void TerminalScreen::eraseInLine(int mode)
+{
+    TerminalLine& line = grid[cursor.row];
+    int from = 0, to = columnCount; // to is exclusive
+    if(mode == 0) from = cursor.column;
+    else if(mode == 1) to = cursor.column + 1;
+    else if(mode != 2) return;
+
+    const TerminalCell blank = blankCell();
+    for(int column = from; column < to; ++column) line.cells[column] = blank;
+    if(mode != 1) line.wrapped = false;
+    cursor.wrapPending = false;
+    damageRows(cursor.row, cursor.row);
+}
+
+void TerminalScreen::eraseCharacters(int count)
+{
+    TerminalLine& line = grid[cursor.row];
+    const int to = qMin(cursor.column + qMax(count, 1), columnCount);
+    const TerminalCell blank = blankCell();
+    for(int column = cursor.column; column < to; ++column) line.cells[column] = blank;
+    cursor.wrapPending = false;
+    damageRows(cursor.row, cursor.row);
+}
+
+void TerminalScreen::insertCharacters(int count)
+{
+    QVector<TerminalCell>& cells = grid[cursor.row].cells;
+    count = qBound(1, count, columnCount - cursor.column);
+    cells.insert(cursor.column, count, blankCell());
+    cells.resize(columnCount);
+    cursor.wrapPending = false;
+    damageRows(cursor.row, cursor.row);
+}
+
+void TerminalScreen::deleteCharacters(int count)
+{
+    QVector<TerminalCell>& cells = grid[cursor.row].cells;
+    count = qBound(1, count, columnCount - cursor.column);
+    cells.remove(cursor.column, count);
+    cells.insert(cells.size(), count, blankCell());
+    cursor.wrapPending = false;
+    damageRows(cursor.row, cursor.row);
+}
+
+void TerminalScreen::insertLines(int count)
+{
+    if(cursor.row < scrollTop || cursor.row > scrollBottom) return;
+    scrollRegionDown(cursor.row, scrollBottom, qMax(count, 1));
+    cursor.column = 0;
+    cursor.wrapPending = false;
+}
+
+void TerminalScreen::deleteLines(int count)
+{
+    if(cursor.row < scrollTop || cursor.row > scrollBottom) return;
+
+    // only whole screen scrolls go into the history, this is a region starting at the cursor
+    count = qMin(qMax(count, 1), scrollBottom - cursor.row + 1);
+    for(int i = 0; i < count; ++i){
+        grid.remove(cursor.row);
+        grid.insert(scrollBottom, blankLine());
+    }
+    damageRows(cursor.row, scrollBottom);
+    cursor.column = 0;
+    cursor.wrapPending = false;
+}
+
+void TerminalScreen::scrollUp(int count)
+{
+    scrollRegionUp(scrollTop, scrollBottom, qMax(count, 1));
+}
+
+void TerminalScreen::scrollDown(int count)
+{
+    scrollRegionDown(scrollTop, scrollBottom, qMax(count, 1));
+}
+
+void TerminalScreen::setScrollRegion(int top, int bottom)
+{
+    top = qBound(0, top, rowCount - 1);
+    bottom = qBound(0, bottom, rowCount - 1);
+    if(top >= bottom) return; // a region has to be at least two lines
+
+    scrollTop = top;
+    scrollBottom = bottom;
+    moveCursor(0, 0);
+}
+
+void TerminalScreen::saveCursor()
+{
+    savedCursor = cursor;
+}
+
+void TerminalScreen::restoreCursor()
+{
+    cursor = savedCursor;
+    cursor.row = qMin(cursor.row, rowCount - 1);
+    cursor.column = qMin(cursor.column, columnCount - 1);
+}
+
+void TerminalScreen::setAlternateScreen(bool on)
+{
+    if(on == alternate) return;
+    alternate = on;
+
+    if(on){
+        mainGrid = std::exchange(grid, QVector<TerminalLine>(rowCount, blankLine()));
+        mainCursor = cursor;
+    }
+    else{
+        grid = std::exchange(mainGrid, QVector<TerminalLine>());
+        cursor = mainCursor;
+    }
+    scrollTop = 0;
+    scrollBottom = rowCount - 1;
+    damageAll();
+}
+
+void TerminalScreen::setCursorVisible(bool visible)
+{
+    showCursor = visible;
+}
+
+void TerminalScreen::setAutoWrap(bool on)
+{
+    autoWrap = on;
+    if(!on) cursor.wrapPending = false;
+}
+
+void TerminalScreen::resize(int columns, int rows)
+{
+    columns = qMax(columns, 1);
+    rows = qMax(rows, 1);
+    if(columns == columnCount && rows == rowCount) return;
+
+    columnCount = columns;
+    rowCount = rows;
+
+    // no reflowing, lines are cut or padded to the new width like xterm does
+    resizeGrid(grid, columns, rows, cursor, !alternate);
+    if(alternate) resizeGrid(mainGrid, columns, rows, mainCursor, true);
+
+    savedCursor.row = qMin(savedCursor.row, rows - 1);
+    savedCursor.column = qMin(savedCursor.column, columns - 1);
+    scrollTop = 0;
+    scrollBottom = rows - 1;
+    damageAll();
+}
+
+void TerminalScreen::resizeGrid(QVector<TerminalLine>& lines, int columns, int rows, Cursor& gridCursor, bool keepInHistory)
+{
+    for(TerminalLine& line : lines){
+        line.cells.resize(columns, TerminalCell());
+    }
+
+    if(lines.size() > rows){
+        // lines above the cursor go into the history, the rest is cut off the bottom
+        const int scrollOff = qMax(gridCursor.row - rows + 1, 0);
+        for(int i = 0; i < scrollOff; ++i){
+            if(keepInHistory) pushToHistory(std::move(lines[i]));
+        }
+        lines.remove(0, scrollOff);
+        lines.resize(rows);
+        gridCursor.row -= scrollOff;
+    }
+    else{
+        // the history moves back down onto the screen to fill the extra rows
+        while(lines.size() < rows && keepInHistory && !history.empty()){
+            TerminalLine line = std::move(history.back());
+            history.pop_back();
+            line.cells.resize(columns, TerminalCell());
+            lines.prepend(std::move(line));
+            gridCursor.row++;
+        }
+        while(lines.size() < rows) lines.append(blankLine());
+    }
+
+    gridCursor.row = qBound(0, gridCursor.row, rows - 1);
+    gridCursor.column = qBound(0, gridCursor.column, columns - 1);
+    gridCursor.wrapPending = false;
+}
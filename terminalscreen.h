@@ -0,0 +1,180 @@
+#ifndef TERMINALSCREEN_H
+#define TERMINALSCREEN_H
+
+#include <QVector>
+#include <QtGlobal>
+#include <climits>
+#include <deque>
+
+// colors are either a palette index (0 to 255), a 24 bit rgb value with TrueColorFlag set, or DefaultColor
+struct TerminalStyle
+{
+    enum Flag : quint8 {
+        Bold = 1,
+        Faint = 2,
+        Italic = 4,
+        Underline = 8,
+        Inverse = 16
+    };
+
+    inline static constexpr quint32 DefaultColor = 0xFFFFFFFF;
+    inline static constexpr quint32 TrueColorFlag = 0x01000000;
+
+    quint32 foreground = DefaultColor;
+    quint32 background = DefaultColor;
+    quint8 flags = 0;
+
+    inline bool operator==(const TerminalStyle& other) const
+    {
+        return foreground == other.foreground && background == other.background && flags == other.flags;
+    }
+    inline bool operator!=(const TerminalStyle& other) const
+    {
+        return !(*this == other);
+    }
+};
+
+struct TerminalCell
+{
+    char32_t character = U' ';
+    TerminalStyle style;
+};
+
+struct TerminalLine
+{
+    QVector<TerminalCell> cells; // screen lines are always the full width, lines in the history can be shorter
+    bool wrapped = false; // ran into the next line by auto wrap rather than a newline, copying joins them back up
+};
+
+// the character grid behind TerminalWidget, AnsiParser turns the shells output into calls on this
+// lines that scroll off the top of the screen go into a history capped at the scrollback limit, the oldest
+// dropped first. everything that changes is recorded as damage (rows in screen coordinates plus how far the
+// whole screen scrolled) so the widget can move what it already painted and only repaint rows that changed
+class TerminalScreen
+{
+public:
+    struct Damage
+    {
+        int firstRow = INT_MAX; // dirty rows, after scrolling
+        int lastRow = -1;
+        int scrolled = 0; // the whole screen moved up this many rows
+        qsizetype droppedFromHistory = 0; // oldest history lines thrown out, line indexes moved down by this much
+        bool all = false; // nothing painted before is any good
+    };
+
+    TerminalScreen(int columns, int rows, int scrollbackLimit);
+
+    inline int columns() const
+    {
+        return columnCount;
+    }
+    inline int rows() const
+    {
+        return rowCount;
+    }
+    inline qsizetype historySize() const
+    {
+        return qsizetype(history.size());
+    }
+    inline qsizetype lineCount() const
+    {
+        return historySize() + rowCount;
+    }
+    const TerminalLine& line(qsizetype index) const; // the history first, then the rows of the screen
+
+    inline int cursorRow() const
+    {
+        return cursor.row;
+    }
+    inline int cursorColumn() const
+    {
+        return cursor.column;
+    }
+    inline bool cursorVisible() const
+    {
+        return showCursor;
+    }
+
+    inline int scrollbackLimit() const
+    {
+        return historyLimit;
+    }
+    void setScrollbackLimit(int lines);
+
+    void resize(int columns, int rows);
+    void reset(); // back to how it started, ESC c
+    void clearAll(); // history and screen, the cursor goes to the top left
+
+    Damage takeDamage();
+
+    inline TerminalStyle& style()
+    {
+        return cursor.style;
+    }
+
+    // everything below is what escape sequences do, rows and columns are zero based
+    void print(char32_t character);
+    void carriageReturn();
+    void lineFeed();
+    void reverseIndex();
+    void backspace();
+    void tab();
+    void moveCursor(int row, int column);
+    void moveCursorBy(int rows, int columns);
+    void eraseInDisplay(int mode); // 0 cursor to end, 1 start to cursor, 2 everything, 3 everything and the history
+    void eraseInLine(int mode); // 0 cursor to end, 1 start to cursor, 2 the whole line
+    void eraseCharacters(int count);
+    void insertCharacters(int count);
+    void deleteCharacters(int count);
+    void insertLines(int count);
+    void deleteLines(int count);
+    void scrollUp(int count);
+    void scrollDown(int count);
+    void setScrollRegion(int top, int bottom);
+    void saveCursor();
+    void restoreCursor();
+    void setAlternateScreen(bool on);
+    void setCursorVisible(bool visible);
+    void setAutoWrap(bool on);
+
+private:
+    struct Cursor
+    {
+        int row = 0;
+        int column = 0;
+        TerminalStyle style;
+        bool wrapPending = false; // printed into the last column, the next character goes on the next line
+    };
+
+    TerminalLine blankLine() const;
+    TerminalCell blankCell() const; // erased cells keep the current background like xterm
+    void scrollRegionUp(int top, int bottom, int count);
+    void scrollRegionDown(int top, int bottom, int count);
+    void pushToHistory(TerminalLine line);
+    void resizeGrid(QVector<TerminalLine>& grid, int columns, int rows, Cursor& gridCursor, bool keepInHistory);
+    void damageRows(int first, int last);
+    void damageAll();
+
+private:
+    int columnCount;
+    int rowCount;
+    int historyLimit;
+
+    QVector<TerminalLine> grid; // rowCount lines of columnCount cells
+    std::deque<TerminalLine> history;
+
+    Cursor cursor;
+    Cursor savedCursor;
+    int scrollTop = 0;
+    int scrollBottom = 0; // inclusive
+    bool autoWrap = true;
+    bool showCursor = true;
+
+    bool alternate = false; // full screen programs draw on their own grid, with no history
+    QVector<TerminalLine> mainGrid; // the normal grid while the alternate one is up
+    Cursor mainCursor;
+
+    Damage damage;
+};
+
+#endif // TERMINALSCREEN_H
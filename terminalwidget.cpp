@@ -0,0 +1,565 @@
+#include "terminalwidget.h"
+#include <QApplication>
+#include <QClipboard>
+#include <QFontDatabase>
+#include <QFontMetrics>
+#include <QKeyEvent>
+#include <QPainter>
+#include <QScrollBar>
+#include <utility>
+
+namespace {
+
+// the xterm defaults for the first 16 palette entries
+constexpr QRgb basicColors[16] = {
+    0x000000, 0xcd0000, 0x00cd00, 0xcdcd00, 0x0000ee, 0xcd00cd, 0x00cdcd, 0xe5e5e5,
+    0x7f7f7f, 0xff0000, 0x00ff00, 0xffff00, 0x5c5cff, 0xff00ff, 0x00ffff, 0xffffff
+};
+
+void appendCharacter(QString& text, char32_t character)
+{
+    if(QChar::requiresSurrogates(character)){
+        text.append(QChar(QChar::highSurrogate(character)));
+        text.append(QChar(QChar::lowSurrogate(character)));
+    }
+    else{
+        text.append(QChar(char16_t(character)));
+    }
+}
+
+} // namespace
+
+TerminalWidget::TerminalWidget(QWidget* parent) :
+    QAbstractScrollArea(parent),
+    screen(80, 24, settings.terminalScrollback()),
+    parser(&screen)
+{
+    // a scroll bar that comes and goes would change the width, and with it the number of columns
+    setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    setFocusPolicy(Qt::StrongFocus);
+    viewport()->setCursor(Qt::IBeamCursor);
+    viewport()->setAttribute(Qt::WA_OpaquePaintEvent); // paintEvent fills every pixel itself
+
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    updateFontMetrics();
+
+    frameTimer.setSingleShot(true);
+    connect(&frameTimer, &QTimer::timeout, this, &TerminalWidget::paintDamage);
+
+    connect(&pty, &PtyProcess::outputReady, this, &TerminalWidget::outputReady);
+    connect(&pty, &PtyProcess::failedToStart, this, &TerminalWidget::shellFailedToStart);
+    connect(&pty, &PtyProcess::finished, this, &TerminalWidget::shellFinished);
+}
+
+bool TerminalWidget::start(const QString& shell, const QString& workingDirectory)
+{
+    updateGridSize();
+    return pty.start(shell, workingDirectory, screen.columns(), screen.rows());
+}
+
+bool TerminalWidget::isRunning() const
+{
+    return pty.isRunning();
+}
+
+void TerminalWidget::sendText(const QString& text)
+{
+    pty.write(text.toUtf8());
+    followOutput();
+}
+
+void TerminalWidget::clear()
+{
+    screen.clearAll();
+    selectionAnchor = CellPosition();
+    scheduleFrame();
+}
+
+void TerminalWidget::setScrollbackLines(int lines)
+{
+    screen.setScrollbackLimit(lines);
+    settings.setTerminalScrollback(lines);
+    scheduleFrame();
+}
+
+void TerminalWidget::outputReady(const QByteArray& output)
+{
+    parser.feed(output);
+
+    const QByteArray replies = parser.takeReplies();
+    if(!replies.isEmpty()) pty.write(replies);
+
+    scheduleFrame();
+}
+
+void TerminalWidget::shellFailedToStart(const QString& message)
+{
+    parser.feed("[" + tr("failed to start the shell: %1").arg(message).toUtf8() + "]\r\n");
+    scheduleFrame();
+}
+
+void TerminalWidget::shellFinished(int exitCode)
+{
+    parser.feed("\r\n[" + tr("process exited with code %1").arg(exitCode).toUtf8() + "]\r\n");
+    scheduleFrame();
+}
+
+void TerminalWidget::scheduleFrame()
+{
+    if(frameTimer.isActive()) return;
+
+    // right away if its been quiet, otherwise whatever is left of the current frame
+    const qint64 sinceLastFrame = lastFrame.isValid() ? lastFrame.elapsed() : frameInterval;
+    frameTimer.start(int(qMax<qint64>(frameInterval - sinceLastFrame, 0)));
+}
+
+int TerminalWidget::cursorViewRow() const
+{
+    return int(screen.historySize() + screen.cursorRow() - verticalScrollBar()->value());
+}
+
+void TerminalWidget::paintDamage()
+{
+    lastFrame.start();
+
+    const TerminalScreen::Damage damage = screen.takeDamage();
+    QScrollBar* scrollBar = verticalScrollBar();
+    const bool following = scrollBar->value() == scrollBar->maximum(); // the range hasnt been updated for this output yet
+
+    // the selection is in line numbers, which moved down with whatever fell out of the history
+    if(damage.droppedFromHistory > 0 && selectionAnchor.line >= 0){
+        selectionAnchor.line -= damage.droppedFromHistory;
+        selectionEnd.line -= damage.droppedFromHistory;
+        if(selectionAnchor.line < 0 || selectionEnd.line < 0) selectionAnchor = CellPosition();
+    }
+
+    adjustingScrollBar = true;
+    const int previousValue = scrollBar->value();
+    scrollBar->setRange(0, int(screen.historySize()));
+    scrollBar->setPageStep(screen.rows());
+    if(following) scrollBar->setValue(scrollBar->maximum());
+    else scrollBar->setValue(previousValue - int(damage.droppedFromHistory)); // stays on the lines being read
+    adjustingScrollBar = false;
+
+    if(!following || damage.all){
+        viewport()->update();
+    }
+    else{
+        if(damage.scrolled > 0){
+            // whats already painted moves up, only the rows that came in at the bottom need painting
+            viewport()->scroll(0, -damage.scrolled * cellHeight);
+            paintedCursorRow -= damage.scrolled;
+        }
+        if(damage.lastRow >= damage.firstRow){
+            viewport()->update(0, damage.firstRow * cellHeight, viewport()->width(), (damage.lastRow - damage.firstRow + 1) * cellHeight);
+        }
+    }
+
+    // the cursor isnt part of the damage, its old and new spots get repainted on their own
+    updateRow(paintedCursorRow);
+    paintedCursorRow = cursorViewRow();
+    updateRow(paintedCursorRow);
+}
+
+void TerminalWidget::updateRow(int viewRow)
+{
+    if(viewRow < 0 || viewRow * cellHeight >= viewport()->height()) return;
+    viewport()->update(0, viewRow * cellHeight, viewport()->width(), cellHeight);
+}
+
+void TerminalWidget::followOutput()
+{
+    QScrollBar* scrollBar = verticalScrollBar();
+    scrollBar->setValue(scrollBar->maximum());
+}
+
+void TerminalWidget::scrollContentsBy(int dx, int dy)
+{
+    Q_UNUSED(dx);
+    Q_UNUSED(dy);
+    if(adjustingScrollBar) return; // paintDamage works out its own repaint
+
+    viewport()->update();
+    paintedCursorRow = cursorViewRow();
+}
+
+void TerminalWidget::updateFontMetrics()
+{
+    QFont base = font();
+    base.setStyleHint(QFont::Monospace);
+    base.setFixedPitch(true);
+    base.setKerning(false);
+
+    for(int i = 0; i < 4; ++i){
+        fonts[i] = base;
+        fonts[i].setBold(i & 1);
+        fonts[i].setItalic(i & 2);
+    }
+
+    const QFontMetrics metrics(base);
+    cellWidth = qMax(metrics.horizontalAdvance(u'M'), 1);
+    cellHeight = qMax(metrics.height(), 1);
+    ascent = metrics.ascent();
+
+    updateGridSize();
+    viewport()->update();
+}
+
+void TerminalWidget::updateGridSize()
+{
+    const int columns = qMax(viewport()->width() / cellWidth, 1);
+    const int rows = qMax(viewport()->height() / cellHeight, 1);
+    if(columns == screen.columns() && rows == screen.rows()) return;
+
+    screen.resize(columns, rows);
+    pty.resize(columns, rows);
+    scheduleFrame();
+}
+
+void TerminalWidget::resizeEvent(QResizeEvent* event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateGridSize();
+}
+
+void TerminalWidget::changeEvent(QEvent* event)
+{
+    QAbstractScrollArea::changeEvent(event);
+    if(event->type() == QEvent::FontChange) updateFontMetrics(); // the .ui sets its own font after construction
+    else if(event->type() == QEvent::PaletteChange) viewport()->update();
+}
+
+void TerminalWidget::focusInEvent(QFocusEvent* event)
+{
+    QAbstractScrollArea::focusInEvent(event);
+    updateRow(cursorViewRow());
+}
+
+void TerminalWidget::focusOutEvent(QFocusEvent* event)
+{
+    QAbstractScrollArea::focusOutEvent(event);
+    updateRow(cursorViewRow());
+}
+
+bool TerminalWidget::focusNextPrevChild(bool next)
+{
+    Q_UNUSED(next);
+    return false;
+}
+
+QColor TerminalWidget::colorFor(quint32 color, bool foreground) const
+{
+    if(color == TerminalStyle::DefaultColor) return palette().color(foreground ? QPalette::Text : QPalette::Base);
+    if(color & TerminalStyle::TrueColorFlag) return QColor(QRgb(color & 0xFFFFFF));
+    if(color < 16) return QColor(basicColors[color]);
+
+    if(color < 232){
+        // the 6x6x6 color cube
+        const int index = int(color) - 16;
+        auto level = [](int value){ return value == 0 ? 0 : 55 + value * 40; };
+        return QColor(level(index / 36), level(index / 6 % 6), level(index % 6));
+    }
+    const int gray = 8 + (int(color) - 232) * 10;
+    return QColor(gray, gray, gray);
+}
+
+const QFont& TerminalWidget::fontFor(quint8 flags) const
+{
+    return fonts[((flags & TerminalStyle::Bold) ? 1 : 0) | ((flags & TerminalStyle::Italic) ? 2 : 0)];
+}
+
+void TerminalWidget::paintEvent(QPaintEvent* event)
+{
+    QPainter painter(viewport());
+    const QRect area = event->rect();
+    painter.fillRect(area, colorFor(TerminalStyle::DefaultColor, false));
+
+    const qsizetype top = verticalScrollBar()->value();
+    const int firstRow = qMax(area.top() / cellHeight, 0);
+    const int lastRow = area.bottom() / cellHeight;
+    for(int row = firstRow; row <= lastRow; ++row){
+        const qsizetype index = top + row;
+        if(index >= screen.lineCount()) break;
+        drawLine(painter, screen.line(index), index, row * cellHeight);
+    }
+
+    // a solid block while focused, just an outline otherwise
+    const int cursorRow = cursorViewRow();
+    if(!screen.cursorVisible() || cursorRow < firstRow || cursorRow > lastRow) return;
+
+    const QRect cell(screen.cursorColumn() * cellWidth, cursorRow * cellHeight, cellWidth, cellHeight);
+    const QColor cursorColor = colorFor(TerminalStyle::DefaultColor, true);
+    if(!hasFocus()){
+        painter.setPen(cursorColor);
+        painter.drawRect(cell.adjusted(0, 0, -1, -1));
+        return;
+    }
+
+    painter.fillRect(cell, cursorColor);
+    const TerminalLine& line = screen.line(top + cursorRow);
+    if(screen.cursorColumn() < line.cells.size()){
+        const TerminalCell& under = line.cells.at(screen.cursorColumn());
+        QString character;
+        appendCharacter(character, under.character);
+        painter.setPen(colorFor(TerminalStyle::DefaultColor, false));
+        painter.setFont(fontFor(under.style.flags));
+        painter.drawText(QPoint(cell.x(), cell.y() + ascent), character);
+    }
+}
+
+void TerminalWidget::drawLine(QPainter& painter, const TerminalLine& line, qsizetype lineIndex, int y)
+{
+    // cells past the end of a history line are blank, they only need visiting if theyre selected
+    const int columns = hasSelection() ? screen.columns() : int(qMin<qsizetype>(line.cells.size(), screen.columns()));
+
+    QString text;
+    bool hasText = false;
+    int runStart = 0;
+    TerminalStyle runStyle;
+    bool runSelected = false;
+
+    // draws the cells from runStart up to end, which all look the same
+    auto drawRun = [&](int end){
+        QColor foreground = colorFor(runStyle.foreground, true);
+        QColor background = colorFor(runStyle.background, false);
+        if((runStyle.flags & TerminalStyle::Bold) && runStyle.foreground < 8) foreground = colorFor(runStyle.foreground + 8, true);
+        if(runStyle.flags & TerminalStyle::Faint) foreground.setAlpha(160);
+        if(runStyle.flags & TerminalStyle::Inverse) std::swap(foreground, background);
+        if(runSelected) std::swap(foreground, background);
+
+        const QRect rect(runStart * cellWidth, y, (end - runStart) * cellWidth, cellHeight);
+        const bool defaultBackground = runStyle.background == TerminalStyle::DefaultColor
+                                       && !(runStyle.flags & TerminalStyle::Inverse) && !runSelected;
+        if(!defaultBackground) painter.fillRect(rect, background);
+
+        if(hasText){
+            painter.setPen(foreground);
+            painter.setFont(fontFor(runStyle.flags));
+            painter.drawText(QPoint(rect.x(), y + ascent), text);
+        }
+        if(runStyle.flags & TerminalStyle::Underline){
+            painter.setPen(foreground);
+            painter.drawLine(rect.left(), y + ascent + 1, rect.right(), y + ascent + 1);
+        }
+    };
+
+    for(int column = 0; column < columns; ++column){
+        const TerminalCell cell = column < line.cells.size() ? line.cells.at(column) : TerminalCell();
+        const bool selected = isSelected(lineIndex, column);
+
+        if(column > runStart && (cell.style != runStyle || selected != runSelected)){
+            drawRun(column);
+            runStart = column;
+            text.clear();
+            hasText = false;
+        }
+        if(column == runStart){
+            runStyle = cell.style;
+            runSelected = selected;
+        }
+
+        appendCharacter(text, cell.character);
+        if(cell.character != U' ') hasText = true;
+    }
+    if(columns > runStart) drawRun(columns);
+}
+
+QByteArray TerminalWidget::keySequence(const QKeyEvent* event, bool applicationCursorKeys)
+{
+    const QByteArray cursorPrefix = applicationCursorKeys ? "\x1bO" : "\x1b[";
+
+    switch(event->key()){
+    case Qt::Key_Return:
+    case Qt::Key_Enter: return "\r";
+    case Qt::Key_Backspace: return "\x7f";
+    case Qt::Key_Tab: return "\t";
+    case Qt::Key_Backtab: return "\x1b[Z";
+    case Qt::Key_Escape: return "\x1b";
+    case Qt::Key_Up: return cursorPrefix + 'A';
+    case Qt::Key_Down: return cursorPrefix + 'B';
+    case Qt::Key_Right: return cursorPrefix + 'C';
+    case Qt::Key_Left: return cursorPrefix + 'D';
+    case Qt::Key_Home: return cursorPrefix + 'H';
+    case Qt::Key_End: return cursorPrefix + 'F';
+    case Qt::Key_Insert: return "\x1b[2~";
+    case Qt::Key_Delete: return "\x1b[3~";
+    case Qt::Key_PageUp: return "\x1b[5~";
+    case Qt::Key_PageDown: return "\x1b[6~";
+    case Qt::Key_F1: return "\x1bOP";
+    case Qt::Key_F2: return "\x1bOQ";
+    case Qt::Key_F3: return "\x1bOR";
+    case Qt::Key_F4: return "\x1bOS";
+    case Qt::Key_F5: return "\x1b[15~";
+    case Qt::Key_F6: return "\x1b[17~";
+    case Qt::Key_F7: return "\x1b[18~";
+    case Qt::Key_F8: return "\x1b[19~";
+    case Qt::Key_F9: return "\x1b[20~";
+    case Qt::Key_F10: return "\x1b[21~";
+    case Qt::Key_F11: return "\x1b[23~";
+    case Qt::Key_F12: return "\x1b[24~";
+    default: break;
+    }
+
+#ifdef Q_OS_MACOS
+    const bool control = event->modifiers() & Qt::MetaModifier; // qt swaps command and control on macs
+#else
+    const bool control = event->modifiers() & Qt::ControlModifier;
+#endif
+    if(control){
+        const int key = event->key();
+        if(key >= Qt::Key_A && key <= Qt::Key_Z) return QByteArray(1, char(key - Qt::Key_A + 1));
+        if(key == Qt::Key_Space || key == Qt::Key_At) return QByteArray(1, '\0');
+        if(key == Qt::Key_BracketLeft) return "\x1b";
+        if(key == Qt::Key_Backslash) return "\x1c";
+        if(key == Qt::Key_BracketRight) return "\x1d";
+    }
+
+    const QByteArray text = event->text().toUtf8();
+    if((event->modifiers() & Qt::AltModifier) && !text.isEmpty()) return "\x1b" + text; // meta sends escape first
+    return text;
+}
+
+void TerminalWidget::keyPressEvent(QKeyEvent* event)
+{
+    // ctrl+c has to reach the shell as an interrupt, so copying and pasting are on ctrl+shift like other terminals
+    const Qt::KeyboardModifiers modifiers = event->modifiers() & (Qt::ControlModifier | Qt::ShiftModifier | Qt::AltModifier);
+    if(modifiers == (Qt::ControlModifier | Qt::ShiftModifier)){
+        if(event->key() == Qt::Key_C){
+            copySelection();
+            return;
+        }
+        if(event->key() == Qt::Key_V){
+            paste();
+            return;
+        }
+    }
+    if(modifiers == Qt::ShiftModifier && (event->key() == Qt::Key_PageUp || event->key() == Qt::Key_PageDown)){
+        verticalScrollBar()->triggerAction(event->key() == Qt::Key_PageUp ? QAbstractSlider::SliderPageStepSub
+                                                                          : QAbstractSlider::SliderPageStepAdd);
+        return;
+    }
+
+    const QByteArray sequence = keySequence(event, parser.applicationCursorKeys());
+    if(sequence.isEmpty()){
+        QAbstractScrollArea::keyPressEvent(event);
+        return;
+    }
+
+    pty.write(sequence);
+    followOutput();
+}
+
+TerminalWidget::CellPosition TerminalWidget::cellAt(const QPoint& point) const
+{
+    CellPosition position;
+    position.line = qBound<qsizetype>(0, verticalScrollBar()->value() + qMax(point.y(), 0) / cellHeight, screen.lineCount() - 1);
+    // between cells rather than on them, so dragging over half a character takes it
+    position.column = qBound(0, (point.x() + cellWidth / 2) / cellWidth, screen.columns());
+    return position;
+}
+
+bool TerminalWidget::hasSelection() const
+{
+    return selectionAnchor.line >= 0 && !(selectionAnchor == selectionEnd);
+}
+
+bool TerminalWidget::isSelected(qsizetype line, int column) const
+{
+    if(!hasSelection()) return false;
+
+    const CellPosition& start = qMin(selectionAnchor, selectionEnd);
+    const CellPosition& end = qMax(selectionAnchor, selectionEnd);
+    const CellPosition position{line, column};
+    return !(position < start) && position < end;
+}
+
+QString TerminalWidget::selectedText() const
+{
+    if(!hasSelection()) return QString();
+
+    const CellPosition start = qMin(selectionAnchor, selectionEnd);
+    const CellPosition end = qMin(qMax(selectionAnchor, selectionEnd), CellPosition{screen.lineCount() - 1, screen.columns()});
+
+    QString text;
+    for(qsizetype index = start.line; index <= end.line; ++index){
+        const TerminalLine& line = screen.line(index);
+        const int from = index == start.line ? start.column : 0;
+        const int to = index == end.line ? end.column : screen.columns();
+
+        QString part;
+        for(int column = from; column < qMin<qsizetype>(to, line.cells.size()); ++column){
+            appendCharacter(part, line.cells.at(column).character);
+        }
+
+        if(index == end.line){
+            text.append(part);
+            break;
+        }
+        // a line that wrapped carries straight on, anything else was a real newline with padding after it
+        if(line.wrapped){
+            text.append(part);
+        }
+        else{
+            while(part.endsWith(u' ')) part.chop(1);
+            text.append(part);
+            text.append(u'\n');
+        }
+    }
+    return text;
+}
+
+void TerminalWidget::copySelection()
+{
+    if(hasSelection()) QApplication::clipboard()->setText(selectedText());
+}
+
+void TerminalWidget::paste()
+{
+    QString text = QApplication::clipboard()->text();
+    if(text.isEmpty()) return;
+
+    // a return is what the enter key sends, a bare newline could mean something else to the program
+    text.replace(QLatin1String("\r\n"), QLatin1String("\r"));
+    text.replace(u'\n', u'\r');
+
+    QByteArray bytes = text.toUtf8();
+    if(parser.bracketedPaste()) bytes = "\x1b[200~" + bytes + "\x1b[201~"; // so shells dont run each line as its pasted
+    pty.write(bytes);
+    followOutput();
+}
+
+void TerminalWidget::mousePressEvent(QMouseEvent* event)
+{
+    if(event->button() == Qt::LeftButton){
+        selectionAnchor = selectionEnd = cellAt(event->position().toPoint());
+        selecting = true;
+        viewport()->update();
+    }
+    else if(event->button() == Qt::MiddleButton && QApplication::clipboard()->supportsSelection()){
+        // the x11 primary selection, like every other terminal there
+        const QByteArray text = QApplication::clipboard()->text(QClipboard::Selection).toUtf8();
+        if(!text.isEmpty()) pty.write(text);
+    }
+    QAbstractScrollArea::mousePressEvent(event);
+}
+
+void TerminalWidget::mouseMoveEvent(QMouseEvent* event)
+{
+    if(selecting){
+        selectionEnd = cellAt(event->position().toPoint());
+        viewport()->update();
+    }
+    QAbstractScrollArea::mouseMoveEvent(event);
+}
+
+void TerminalWidget::mouseReleaseEvent(QMouseEvent* event)
+{
+    if(selecting && event->button() == Qt::LeftButton){
+        selecting = false;
+        if(hasSelection() && QApplication::clipboard()->supportsSelection()){
+            QApplication::clipboard()->setText(selectedText(), QClipboard::Selection);
+        }
+    }
+    QAbstractScrollArea::mouseReleaseEvent(event);
+}
@@ -0,0 +1,119 @@
+#ifndef TERMINALWIDGET_H
+#define TERMINALWIDGET_H
+
+#include <QAbstractScrollArea>
+#include <QElapsedTimer>
+#include <QFont>
+#include <QTimer>
+#include "ansiparser.h"
+#include "ptyprocess.h"
+#include "settingshelper.h"
+#include "terminalscreen.h"
+
+class QPainter;
+
+// the terminal dock, a shell on a PtyProcess drawn as a grid of character cells
+// output goes straight through AnsiParser into the TerminalScreen as it arrives, painting waits for the next
+// frame tick and only touches the rows the screen reports as damaged. when the output just scrolls, whats
+// already on screen is moved up with QWidget::scroll and only the new rows get painted. keys go to the shell
+// as the bytes a terminal would send, the history can be scrolled and selected with the mouse and copied
+class TerminalWidget : public QAbstractScrollArea
+{
+public:
+    explicit TerminalWidget(QWidget* parent = nullptr);
+
+    bool start(const QString& shell, const QString& workingDirectory);
+    bool isRunning() const;
+    void sendText(const QString& text); // as if it was typed
+    void clear();
+
+    inline int scrollbackLines() const
+    {
+        return screen.scrollbackLimit();
+    }
+    void setScrollbackLines(int lines); // also saved as the setting
+
+    inline QString errorString() const
+    {
+        return pty.errorString();
+    }
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+    void changeEvent(QEvent* event) override;
+    void keyPressEvent(QKeyEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+    void mouseReleaseEvent(QMouseEvent* event) override;
+    void focusInEvent(QFocusEvent* event) override;
+    void focusOutEvent(QFocusEvent* event) override;
+    void scrollContentsBy(int dx, int dy) override;
+    bool focusNextPrevChild(bool next) override; // tab is for the shell, not for moving focus
+
+private:
+    // a spot in the terminal, line counts from the top of the history
+    struct CellPosition
+    {
+        qsizetype line = -1;
+        int column = 0;
+
+        inline bool operator<(const CellPosition& other) const
+        {
+            return line < other.line || (line == other.line && column < other.column);
+        }
+        inline bool operator==(const CellPosition& other) const
+        {
+            return line == other.line && column == other.column;
+        }
+    };
+
+    void outputReady(const QByteArray& output);
+    void shellFailedToStart(const QString& message); // only known once the child has tried, start already returned
+    void shellFinished(int exitCode);
+    void scheduleFrame();
+    void paintDamage(); // the frame tick, works out what actually has to be repainted
+    void updateFontMetrics();
+    void updateGridSize();
+    void updateRow(int viewRow);
+    void followOutput(); // back down to the screen, like typing does in every terminal
+    int cursorViewRow() const;
+
+    void drawLine(QPainter& painter, const TerminalLine& line, qsizetype lineIndex, int y);
+    QColor colorFor(quint32 color, bool foreground) const;
+    const QFont& fontFor(quint8 flags) const;
+
+    CellPosition cellAt(const QPoint& point) const;
+    bool hasSelection() const;
+    bool isSelected(qsizetype line, int column) const;
+    QString selectedText() const;
+    void copySelection();
+    void paste();
+
+    static QByteArray keySequence(const QKeyEvent* event, bool applicationCursorKeys);
+
+private:
+    inline static constexpr int frameInterval = 16; // milliseconds, repaints are batched to about 60 a second
+
+    SettingsHelper settings;
+    TerminalScreen screen;
+    AnsiParser parser;
+    PtyProcess pty;
+
+    QTimer frameTimer;
+    QElapsedTimer lastFrame;
+    bool adjustingScrollBar = false; // scroll bar changes made by paintDamage, which repaints on its own
+    int paintedCursorRow = -1; // view row the cursor was last drawn on
+
+    QFont fonts[4]; // regular, bold, italic, bold italic
+    int cellWidth = 8;
+    int cellHeight = 16;
+    int ascent = 12;
+
+    // selections run from anchor to end in reading order, whichever way the mouse went
+    CellPosition selectionAnchor;
+    CellPosition selectionEnd;
+    bool selecting = false;
+};
+
+#endif // TERMINALWIDGET_H
@@ -0,0 +1,163 @@
+#include "textbuffer.h"
+
+TextBuffer::TextBuffer(const QString& text)
+{
+    if(!text.isEmpty()){
+        buffers.append(text); // shares the string, no copy
+        pieces.append(Piece{0, 0, text.size()});
+        length = text.size();
+    }
+}
+
+void TextBuffer::clear()
+{
+    buffers.clear();
+    pieces.clear();
+    invalidateOffsets(0);
+    length = 0;
+    revisionNumber++;
+}
+
+void TextBuffer::replace(qsizetype position, qsizetype removed, QStringView inserted)
+{
+    Q_ASSERT(position >= 0 && removed >= 0 && position + removed <= length);
+    if(removed == 0 && inserted.isEmpty()) return;
+    revisionNumber++;
+
+    qsizetype index = splitAt(position);
+    invalidateOffsets(index); // everything from here on moves, and the piece before it might grow
+    if(removed > 0){
+        const qsizetype end = splitAt(position + removed);
+        pieces.remove(index, end - index);
+        length -= removed;
+    }
+
+    if(inserted.isEmpty()) return;
+
+    // never write into a buffer someone else still holds (a snapshot), start a new one instead
+    if(buffers.isEmpty() || !buffers.last().isDetached()){
+        buffers.append(QString());
+    }
+    const int bufferIndex = buffers.size() - 1;
+    QString& buffer = buffers.last();
+
+    // typing usually continues right where the last insert ended, so grow that piece instead of adding one
+    if(index > 0){
+        Piece& previous = pieces[index - 1];
+        if(previous.buffer == bufferIndex && previous.start + previous.length == buffer.size()){
+            buffer.append(inserted);
+            previous.length += inserted.size();
+            length += inserted.size();
+            return;
+        }
+    }
+
+    pieces.insert(index, Piece{bufferIndex, buffer.size(), inserted.size()});
+    buffer.append(inserted);
+    length += inserted.size();
+}
+
+QChar TextBuffer::at(qsizetype position) const
+{
+    const qsizetype index = pieceAt(position);
+    if(index == pieces.size()) return QChar();
+
+    const Piece& piece = pieces.at(index);
+    return buffers.at(piece.buffer).at(piece.start + position - offsets.at(index));
+}
+
+QString TextBuffer::mid(qsizetype position, qsizetype count) const
+{
+    QString text;
+    text.reserve(count);
+    forEachChunk(position, count, [&text](QStringView chunk){
+        text.append(chunk);
+    });
+    return text;
+}
+
+QString TextBuffer::toString() const
+{
+    if(pieces.size() == 1 && pieces.first().start == 0 && pieces.first().length == buffers.at(pieces.first().buffer).size()){
+        return buffers.at(pieces.first().buffer); // shared, no copy
+    }
+    return mid(0, length);
+}
+
+bool TextBuffer::matches(qsizetype position, QStringView text) const
+{
+    if(position < 0 || position + text.size() > length) return false;
+
+    bool equal = true;
+    qsizetype compared = 0;
+    forEachChunk(position, text.size(), [&](QStringView chunk){
+        if(equal && chunk != text.mid(compared, chunk.size())) equal = false;
+        compared += chunk.size();
+    });
+    return equal;
+}
+
+QStringView TextBuffer::view(qsizetype position, qsizetype count, QString* scratch) const
+{
+    const qsizetype index = pieceAt(position);
+    if(index < pieces.size()){
+        const Piece& piece = pieces.at(index);
+        const qsizetype from = position - offsets.at(index);
+        if(from + count <= piece.length) return pieceView(piece).mid(from, count);
+    }
+    *scratch = mid(position, count);
+    return *scratch;
+}
+
+qsizetype TextBuffer::pieceAt(qsizetype position) const
+{
+    if(position < 0 || position >= length) return pieces.size();
+    if(offsets.size() != pieces.size()) offsets.resize(pieces.size());
+
+    // carry on from the last piece with a known offset until one covers position, pieces are never empty so this
+    // stops before running off the end
+    qsizetype end = validOffsets == 0 ? 0 : offsets.at(validOffsets - 1) + pieces.at(validOffsets - 1).length;
+    while(end <= position){
+        offsets[validOffsets] = end;
+        end += pieces.at(validOffsets).length;
+        validOffsets++;
+    }
+
+    // the last piece starting at or before position
+    const auto next = std::upper_bound(offsets.cbegin(), offsets.cbegin() + validOffsets, position);
+    return (next - offsets.cbegin()) - 1;
+}
+
+qsizetype TextBuffer::splitAt(qsizetype position)
+{
+    const qsizetype index = pieceAt(position);
+    if(index == pieces.size() || offsets.at(index) == position) return index;
+
+    Piece& piece = pieces[index];
+    const qsizetype headLength = position - offsets.at(index);
+    const Piece tail{piece.buffer, piece.start + headLength, piece.length - headLength};
+    piece.length = headLength;
+    pieces.insert(index + 1, tail);
+    invalidateOffsets(index + 1);
+    return index + 1;
+}
+
+void TextBuffer::compact()
+{
+    // the text stays the same so the revision does too, anything compared against it is still valid
+    QString text = mid(0, length);
+    buffers.clear();
+    pieces.clear();
+    invalidateOffsets(0);
+    if(!text.isEmpty()){
+        buffers.append(std::move(text));
+        pieces.append(Piece{0, 0, length});
+    }
+}
+
+TextBuffer TextBuffer::compacted() const
+{
+    TextBuffer merged(*this); // shares the buffers, compact() then builds a new one instead of touching them
+    merged.compact();
+    return merged;
+}
@@ -0,0 +1,126 @@
+#ifndef TEXTBUFFER_H
+#define TEXTBUFFER_H
+
+#include <QString>
+#include <QStringView>
+#include <QVector>
+#include <algorithm>
+
+// piece table mirror of an editor's document
+// the text is a list of pieces pointing into append only buffers, so an edit only touches the piece list
+// and never copies the document. copying a TextBuffer is cheap (the buffers are implicitly shared and never
+// modified once shared), which is how other threads get a snapshot of the document to work on
+class TextBuffer
+{
+public:
+    TextBuffer() = default;
+    explicit TextBuffer(const QString& text);
+
+    inline qsizetype size() const
+    {
+        return length;
+    }
+    inline bool isEmpty() const
+    {
+        return length == 0;
+    }
+
+    void clear();
+
+    // goes up by one on every change to the text, snapshots keep the revision they were taken at
+    inline quint64 revision() const
+    {
+        return revisionNumber;
+    }
+
+    // removes `removed` characters at position and inserts `inserted` in their place
+    void replace(qsizetype position, qsizetype removed, QStringView inserted);
+    inline void insert(qsizetype position, QStringView text)
+    {
+        replace(position, 0, text);
+    }
+
+    QChar at(qsizetype position) const;
+    QString mid(qsizetype position, qsizetype count) const;
+    QString toString() const;
+
+    // true if the text at position is exactly `text`, compares piece by piece without copying
+    bool matches(qsizetype position, QStringView text) const;
+
+    // lookups stay cheap however many pieces there are, but past this many merging them back together saves memory
+    // and keeps snapshots small. the merge copies the whole text so its left to the owner, see compacted()
+    inline bool needsCompacting() const
+    {
+        return pieces.size() > maxPieces;
+    }
+    // a copy with every piece merged into one buffer and the same revision, fine to call on a snapshot on any thread
+    TextBuffer compacted() const;
+
+    // the characters in [position, position + count) as one view. points straight into the piece when they all
+    // sit in one, otherwise theyre copied into scratch, so only whats asked for ever gets copied
+    QStringView view(qsizetype position, qsizetype count, QString* scratch) const;
+
+    // calls function with a view of every piece in order, nothing gets copied
+    template<typename Function>
+    void forEachChunk(Function function) const
+    {
+        forEachChunk(0, length, function);
+    }
+
+    // same as above but only for the characters in [position, position + count)
+    template<typename Function>
+    void forEachChunk(qsizetype position, qsizetype count, Function function) const
+    {
+        const qsizetype end = position + count;
+        for(qsizetype index = pieceAt(position); index < pieces.size(); ++index){
+            const Piece& piece = pieces.at(index);
+            const qsizetype offset = offsets.at(index);
+            if(offset >= end) break;
+
+            const qsizetype from = qMax(position, offset) - offset;
+            const qsizetype to = qMin(end, offset + piece.length) - offset;
+            function(pieceView(piece).mid(from, to - from));
+
+            // pieceAt only made sure the offsets up to the first piece are known, the rest are worked out as it goes
+            if(index + 1 == validOffsets && index + 1 < pieces.size()){
+                offsets[validOffsets++] = offset + piece.length;
+            }
+        }
+    }
+
+private:
+    struct Piece
+    {
+        int buffer; // index into buffers
+        qsizetype start;
+        qsizetype length;
+    };
+
+    inline QStringView pieceView(const Piece& piece) const
+    {
+        return QStringView(buffers.at(piece.buffer)).mid(piece.start, piece.length);
+    }
+
+    // index of the piece holding position, pieces.size() at or past the end. the offsets up to it are valid after
+    qsizetype pieceAt(qsizetype position) const;
+    inline void invalidateOffsets(qsizetype from) // the pieces from here on changed, their offsets get redone on the next lookup
+    {
+        validOffsets = qMin(validOffsets, from);
+    }
+
+    qsizetype splitAt(qsizetype position); // makes a piece boundary at position, returns the index of the piece after it
+    void compact(); // merges every piece into a single fresh buffer, keeps the revision
+
+    inline static constexpr qsizetype maxPieces = 8192;
+
+    QVector<QString> buffers;
+    QVector<Piece> pieces;
+    // where each piece starts in the text, for binary searching a position. an edit only invalidates the ones after it
+    // and theyre redone lazily up to wherever the next lookup lands, so typing in one spot doesnt walk the whole list
+    mutable QVector<qsizetype> offsets;
+    mutable qsizetype validOffsets = 0;
+    qsizetype length = 0;
+    quint64 revisionNumber = 0;
+};
+
+#endif // TEXTBUFFER_H